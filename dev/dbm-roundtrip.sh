@@ -0,0 +1,112 @@
+#!/bin/bash
+# Round trip of the write commands of pidbm on a copy of a SQLite database,
+# stops at the first step that fails.
+# Usage: dev/dbm-roundtrip.sh piduino.db [board]
+#   piduino.db  a SQLite database, it is copied and not modified
+#   board       id of the board cloned by the round trip (default: the first one)
+# The pidbm command used can be changed with the PIDBM variable, the sqlite3
+# command line shell is used to check the results.
+#
+# The copy is cleaned by dedup and gc, then a gpio and a board are cloned by
+# cp, the clone is modified by mod, its connectors are merged back by dedup,
+# it is removed by rm and gc: check must pass at each step and the hash of
+# the database must be the one of the start.
+
+set -e
+
+DB=$1
+PIDBM=${PIDBM:-pidbm}
+
+if [ ! -f "$DB" ]; then
+  echo "Usage: $0 piduino.db [board]" >&2
+  exit 1
+fi
+
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+cp "$DB" "$TMP/piduino.db"
+cinfo="sqlite3:db=$TMP/piduino.db"
+
+run() {
+  $PIDBM -q -c "$cinfo" "$@"
+}
+
+sql() {
+  sqlite3 "$TMP/piduino.db" "$1"
+}
+
+step() {
+  echo "- $1"
+}
+
+fail() {
+  echo "FAILED: $1" >&2
+  exit 1
+}
+
+expect() {
+  [ "$2" = "$3" ] || fail "$1, '$2' instead of '$3'"
+}
+
+BOARD=${2:-$(sql "SELECT MIN(id) FROM board")}
+GPIO=$(sql "SELECT gpio_id FROM board WHERE id=$BOARD")
+[ -n "$GPIO" ] || fail "board $BOARD not found"
+
+step "read-only commands do not write"
+journal="SELECT COUNT(*) FROM sqlite_master WHERE name='pidbm_journal'"
+before=$(sql "$journal")
+run list arch > /dev/null
+expect "pidbm_journal created by list" "$(sql "$journal")" $before
+
+step "dedup, gc and check"
+run dedup connectors > /dev/null
+run gc > /dev/null
+run check
+base=$(run hash)
+connectors=$(sql "SELECT COUNT(*) FROM connector")
+
+step "dry run"
+run -n mod board id=$BOARD set ram=4242 > /dev/null
+run -n gc > /dev/null
+expect "hash after the dry runs" "$(run hash)" "$base"
+
+step "cp gpio"
+run cp gpio $GPIO rt-gpio > /dev/null
+rt_gpio=$(sql "SELECT id FROM gpio WHERE name='rt-gpio'")
+[ -n "$rt_gpio" ] || fail "rt-gpio not copied"
+expect "connectors of rt-gpio" \
+  "$(sql "SELECT COUNT(*) FROM gpio_has_connector WHERE gpio_id=$rt_gpio")" \
+  "$(sql "SELECT COUNT(*) FROM gpio_has_connector WHERE gpio_id=$GPIO")"
+expect "pins of rt-gpio" \
+  "$(sql "SELECT COUNT(*) FROM gpio_has_pin WHERE gpio_id=$rt_gpio")" \
+  "$(sql "SELECT COUNT(*) FROM gpio_has_pin WHERE gpio_id=$GPIO")"
+run check
+
+step "cp board"
+run cp board $BOARD rt-board -trt-board > /dev/null
+rt_board=$(sql "SELECT board_id FROM tag WHERE tag='rt-board'")
+[ -n "$rt_board" ] || fail "rt-board not copied"
+expect "name of rt-board" "$(sql "SELECT name FROM board WHERE id=$rt_board")" rt-board
+
+step "mod set"
+run mod board name=rt-board set ram=4242 gpio_id=$rt_gpio > /dev/null
+expect "ram of rt-board" "$(sql "SELECT ram FROM board WHERE id=$rt_board")" 4242
+expect "gpio of rt-board" "$(sql "SELECT gpio_id FROM board WHERE id=$rt_board")" $rt_gpio
+run check
+
+step "dedup connectors"
+run dedup connectors > /dev/null
+expect "connectors after dedup" "$(sql "SELECT COUNT(*) FROM connector")" $connectors
+run check
+
+step "rm and gc"
+run rm board rt-board > /dev/null
+run rm gpio rt-gpio > /dev/null
+run gc > /dev/null
+run check
+expect "hash after the round trip" "$(run hash)" "$base"
+
+step "journal"
+[ "$(run log | wc -l)" -gt 0 ] || fail "no journal entries"
+
+echo "Round trip passed."
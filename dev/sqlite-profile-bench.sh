@@ -0,0 +1,149 @@
+#!/bin/bash
+# Compares the SQLite profiles of pidbm on the list and bulk insertion paths.
+# Usage: dev/sqlite-profile-bench.sh piduino.db [gpio] [runs]
+#   piduino.db  a SQLite database, it is copied and not modified
+#   gpio        Gpio renumbered by the bulk insertion path (default: 1)
+#   runs        number of runs of each path (default: 20)
+# The pidbm command used can be changed with the PIDBM variable, the sqlite3
+# shell must be installed, the copies
+# are made in TMPDIR, on the storage to measure.
+# The times are in milliseconds per run. The startup of pidbm, measured by
+# list arch (a process, the opening of the database and its pragmas, a query
+# of one row), is subtracted from the other paths, so that they give the time
+# of the command itself.
+# When a C compiler is available, the fsync() and fdatasync() of a run of each
+# path are also counted, by a library preloaded in pidbm. Their number does
+# not depend on the noise of the timings, multiplied by the sync latency of
+# the target storage it gives the cost of a profile there.
+# add is also measured while the sqlite3 shell holds the database open: in WAL
+# mode the last connection closed checkpoints the database, which syncs, an
+# application using the database saves this checkpoint to pidbm.
+
+set -e
+
+DB=$1
+GPIO=${2:-1}
+RUNS=${3:-20}
+PIDBM=${PIDBM:-pidbm}
+
+if [ ! -f "$DB" ]; then
+  echo "Usage: $0 piduino.db [gpio] [runs]" >&2
+  exit 1
+fi
+
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+SYNCS=
+if command -v cc > /dev/null; then
+  cat > "$TMP/syncs.c" << 'EOF'
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static int count;
+
+static void report (void) {
+  FILE * f = fopen (getenv ("SYNCS_OUT"), "w");
+  if (f) {
+    fprintf (f, "%d\n", count);
+    fclose (f);
+  }
+}
+
+__attribute__ ((constructor)) static void init (void) {
+  atexit (report);
+}
+
+int fsync (int fd) {
+  static int (*next) (int);
+  if (!next) {
+    next = dlsym (RTLD_NEXT, "fsync");
+  }
+  count++;
+  return next (fd);
+}
+
+int fdatasync (int fd) {
+  static int (*next) (int);
+  if (!next) {
+    next = dlsym (RTLD_NEXT, "fdatasync");
+  }
+  count++;
+  return next (fd);
+}
+EOF
+  if cc -shared -fPIC -O2 -o "$TMP/syncs.so" "$TMP/syncs.c" -ldl 2> /dev/null; then
+    SYNCS="$TMP/syncs.so"
+  fi
+fi
+
+# elapsed time of a run of the function $1, in milliseconds, minus $2 (the
+# startup), the mean of $RUNS runs, $i is the run
+bench() {
+  local start end
+  start=$(date +%s.%N)
+  for ((i = 0; i < RUNS; i++)); do
+    $1 > /dev/null
+  done
+  end=$(date +%s.%N)
+  awk "BEGIN { printf \"%.2f\", ($end - $start) * 1000 / $RUNS - ${2:-0} }"
+}
+
+# number of syncs of a run of the function $1, - if they can not be counted
+syncs() {
+  if [ -z "$SYNCS" ]; then
+    echo "-"
+    return
+  fi
+  i=syncs
+  SYNCS_OUT="$TMP/syncs.out" LD_PRELOAD="$SYNCS" $1 > /dev/null
+  cat "$TMP/syncs.out"
+}
+
+startup() {
+  $PIDBM "${opt[@]}" list arch
+}
+
+list_pin() {
+  $PIDBM "${opt[@]}" list pin
+}
+
+gen_ino() {
+  $PIDBM "${opt[@]}" gen ino "$GPIO"
+}
+
+# one commit per run, where synchronous matters most, $pass makes the names
+# unique between the passes
+add_manufacturer() {
+  $PIDBM "${opt[@]}" add manufacturer "bench-$pass-$i"
+}
+
+echo "milliseconds per run, syncs per run in parentheses"
+printf "%-10s %12s %14s %14s %14s %14s\n" profile "startup" "list pin" "gen ino" "add" "add (open)"
+for profile in default durable fast; do
+  # journal_mode=WAL is persistent, each profile has its own copy
+  cp "$DB" "$TMP/$profile.db"
+  cinfo="sqlite3:db=$TMP/$profile.db"
+  opt=(-q -c "$cinfo" --sqlite-profile "$profile")
+
+  start=$(bench startup)
+  list="$(bench list_pin $start) ($(syncs list_pin))"
+  gen="$(bench gen_ino $start) ($(syncs gen_ino))"
+  pass=closed
+  add="$(bench add_manufacturer $start) ($(syncs add_manufacturer))"
+
+  # a reader holding the database open, until its input is closed
+  mkfifo "$TMP/hold"
+  sqlite3 "$TMP/$profile.db" < "$TMP/hold" > /dev/null &
+  exec 3> "$TMP/hold"
+  echo "SELECT COUNT(*) FROM arch;" >&3
+  sleep 1
+  pass=open
+  held="$(bench add_manufacturer $start) ($(syncs add_manufacturer))"
+  exec 3>&-
+  wait
+  rm "$TMP/hold"
+  printf "%-10s %12s %14s %14s %14s %14s\n" $profile $start "$list" "$gen" "$add" "$held"
+done
@@ -15,6 +15,9 @@
  */
 #include <exception>
 #include "board.h"
+#include "gpio.h"
+#include "soc.h"
+#include "digest.h"
 
 using namespace std;
 
@@ -38,4 +41,87 @@ void BoardFamily::setId (long long id) {
   _id = id;
 }
 
+// ---------------------------------------------------------------------------
+//
+//                             Board Class
+//
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+Board::Board (cppdb::session & d, long long i) : _db (d), _id (i),
+  _board_family_id (-1), _soc_id (-1), _gpio_id (-1), _manufacturer_id (-1) {
+
+  if (i >= 0) {
+    setId (i);
+  }
+}
+
+// ---------------------------------------------------------------------------
+void Board::setId (long long i) {
+  cppdb::result res =
+    _db << "SELECT board.name,board_model.name,board_family_id,soc_id,"
+    "gpio_id,manufacturer_id,"
+    "ram,pcb_revision,default_i2c_id,default_spi_id,default_uart_id "
+    "FROM board "
+    "INNER JOIN board_model ON board_model.id=board_model_id "
+    "WHERE board.id=?"
+    << i << cppdb::row;
+
+  if (res.empty()) {
+
+    throw std::invalid_argument ("Board not found");
+  }
+  res >> _name >> _model >> _board_family_id >> _soc_id
+      >> _gpio_id >> _manufacturer_id;
+  _values.clear();
+  for (int c = 6; c < res.cols(); c++) {
+    string v;
+
+    if (!res.fetch (c, v)) {
+      v = "NULL";
+    }
+    _values.push_back (v);
+  }
+  _id = i;
+
+  _tags.clear();
+  res = _db << "SELECT tag FROM tag WHERE board_id=? ORDER BY tag" << _id;
+  while (res.next()) {
+    string t;
+
+    res >> t;
+    _tags.push_back (t);
+  }
+
+  _revisions.clear();
+  res = _db << "SELECT revision FROM revision WHERE board_id=? ORDER BY revision" << _id;
+  while (res.next()) {
+    string r;
+
+    res >> r;
+    _revisions.push_back (r);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Merkle hash: the board record combined with the hashes of its Gpio and Soc
+uint64_t Board::hash() const {
+  Digest d;
+
+  d << _id << _name << _model << _board_family_id << _manufacturer_id;
+  for (auto & v : _values) {
+    d << v;
+  }
+  d << static_cast<uint64_t> (_tags.size());
+  for (auto & t : _tags) {
+    d << t;
+  }
+  d << static_cast<uint64_t> (_revisions.size());
+  for (auto & r : _revisions) {
+    d << r;
+  }
+  d << Gpio (_db, _gpio_id).hash() << Soc (_db, _soc_id).hash();
+  return d.value();
+}
+
 /* ========================================================================== */
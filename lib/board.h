@@ -16,6 +16,8 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <cstdint>
 #include <cppdb/frontend.h>
 
 class BoardFamily {
@@ -35,4 +37,50 @@ class BoardFamily {
     std::string _name;
 };
 
+class Board {
+  public:
+    Board (cppdb::session & db, long long id = -1);
+    void setId (long long id);
+    uint64_t hash() const;
+
+    inline long long id() const {
+      return _id;
+    }
+    inline const std::string & name() const {
+      return _name;
+    }
+    inline const std::string & model() const {
+      return _model;
+    }
+    inline long long gpioId() const {
+      return _gpio_id;
+    }
+    inline long long socId() const {
+      return _soc_id;
+    }
+    inline const std::vector<std::string> & tags() const {
+      return _tags;
+    }
+    inline const std::vector<std::string> & revisions() const {
+      return _revisions;
+    }
+    inline cppdb::session & db() const  {
+      return _db;
+    }
+
+  private:
+    cppdb::session & _db;
+    long long _id;
+    std::string _name;
+    std::string _model;
+    long long _board_family_id;
+    long long _soc_id;
+    long long _gpio_id;
+    long long _manufacturer_id;
+    // ram, pcb_revision and the default buses, as read, NULL if empty
+    std::vector<std::string> _values;
+    std::vector<std::string> _tags;
+    std::vector<std::string> _revisions;
+};
+
 /* ========================================================================== */
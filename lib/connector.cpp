@@ -20,6 +20,7 @@
 #include "gpio.h"
 #include "connector.h"
 #include "pin.h"
+#include "digest.h"
 
 using namespace std;
 
@@ -143,14 +144,17 @@ Connector::Connector (const Connector & src, const std::string & n) :
   st.exec();
   _id = st.last_insert_id();
 
+  // the pins are copied by the server in a single statement
+  st = _db << "INSERT INTO connector_has_pin(connector_id,pin_id,row,column) "
+       "SELECT ?,pin_id,row,column FROM connector_has_pin WHERE connector_id=?"
+       << _id << src.id();
+  st.exec();
+
   for (size_t i = 1; i <= src.size(); i++) {
     std::shared_ptr<Pin> p;
 
     p = std::make_shared<Pin> (*this, src.pin (i));
     _pin[p->number()] = p;
-    st = _db << "INSERT INTO connector_has_pin(connector_id,pin_id,row,column) VALUES(?,?,?,?)"
-         << _id << p->id() << p->row() << p->column();
-    st.exec();
   }
 }
 
@@ -226,6 +230,19 @@ bool Connector::updatePin (size_t r, size_t c, long long pin_id) {
   return false;
 }
 
+// -----------------------------------------------------------------------------
+uint64_t Connector::hash() const {
+  Digest d;
+
+  d << _id << _name << static_cast<uint64_t> (_rows)
+    << _family.id() << _family.name() << static_cast<uint64_t> (_family.columns());
+  for (auto & p : _pin) {
+
+    d << static_cast<uint64_t> (p.first) << p.second->hash();
+  }
+  return d.value();
+}
+
 // -----------------------------------------------------------------------------
 void Connector::print (std::ostream& os) const {
   std::string::size_type width = 0;
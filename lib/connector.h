@@ -16,6 +16,7 @@
 #pragma once
 
 #include <string>
+#include <cstdint>
 #include <array>
 #include <map>
 #include <iostream>
@@ -64,6 +65,7 @@ class Connector {
     void print (std::ostream& os) const;
     size_t pinNumber (size_t row, size_t column) const;
     void setId (long long id);
+    uint64_t hash() const;
 
     inline long long id() const {
       return _id;
@@ -95,6 +97,9 @@ class Connector {
     inline const Pin & pin (size_t number) const {
       return *_pin.at (number).get();
     }
+    inline bool hasPin (size_t number) const {
+      return _pin.count (number) > 0;
+    }
 
     friend std::ostream& operator<< (std::ostream& os, const Connector & c);
 
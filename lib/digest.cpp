@@ -0,0 +1,91 @@
+/* Copyright © 2020 Pascal JEAN, All rights reserved.
+ *
+ * Piduino pidbm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Piduino pidbm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Piduino pidbm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <iomanip>
+#include <sstream>
+#include "digest.h"
+
+using namespace std;
+
+// ---------------------------------------------------------------------------
+//
+//                             Digest Class
+//
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+void Digest::update (const void * data, size_t len) {
+  const unsigned char * p = static_cast<const unsigned char *> (data);
+
+  for (size_t i = 0; i < len; i++) {
+
+    _value ^= p[i];
+    _value *= Prime;
+  }
+}
+
+// ---------------------------------------------------------------------------
+Digest & Digest::operator<< (uint64_t v) {
+  unsigned char b[8];
+
+  // little endian whatever the host is
+  for (int i = 0; i < 8; i++) {
+    b[i] = static_cast<unsigned char> (v >> (8 * i));
+  }
+  update (b, sizeof (b));
+  return *this;
+}
+
+// ---------------------------------------------------------------------------
+Digest & Digest::operator<< (long long v) {
+
+  return *this << static_cast<uint64_t> (v);
+}
+
+// ---------------------------------------------------------------------------
+Digest & Digest::operator<< (const std::string & s) {
+
+  *this << static_cast<uint64_t> (s.size());
+  update (s.data(), s.size());
+  return *this;
+}
+
+// ---------------------------------------------------------------------------
+Digest & Digest::operator<< (const char * s) {
+
+  return *this << string (s);
+}
+
+// ---------------------------------------------------------------------------
+Digest & Digest::addNull() {
+
+  // a length that no string can have
+  return *this << static_cast<uint64_t> (-1);
+}
+
+// ---------------------------------------------------------------------------
+std::string Digest::toString() const {
+
+  return toString (_value);
+}
+
+// ---------------------------------------------------------------------------
+std::string Digest::toString (uint64_t value) {
+  ostringstream s;
+
+  s << hex << setfill ('0') << setw (16) << value;
+  return s.str();
+}
+/* ========================================================================== */
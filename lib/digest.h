@@ -0,0 +1,52 @@
+/* Copyright © 2020 Pascal JEAN, All rights reserved.
+ *
+ * Piduino pidbm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Piduino pidbm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Piduino pidbm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+// 64-bit FNV-1a digest of a sequence of values.
+// Each string is prefixed with its length, so that ("ab","c") and ("a","bc")
+// give different digests. The value does not depend on the backend nor on the
+// host byte order, it can be stored and compared by the clients.
+class Digest {
+  public:
+    Digest() : _value (Offset) {}
+
+    Digest & operator<< (const std::string & s);
+    Digest & operator<< (const char * s);
+    Digest & operator<< (long long v);
+    Digest & operator<< (uint64_t v);
+    inline Digest & operator<< (int v) {
+      return *this << static_cast<long long> (v);
+    }
+    Digest & addNull();
+
+    inline uint64_t value() const {
+      return _value;
+    }
+    std::string toString() const;
+    // 16 hexadecimal digits, as toString()
+    static std::string toString (uint64_t value);
+
+  private:
+    void update (const void * data, size_t len);
+
+    uint64_t _value;
+    static const uint64_t Offset = 14695981039346656037ULL;
+    static const uint64_t Prime = 1099511628211ULL;
+};
+/* ========================================================================== */
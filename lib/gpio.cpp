@@ -17,6 +17,7 @@
 #include <iomanip>
 #include "gpio.h"
 #include "connector.h"
+#include "digest.h"
 
 using namespace std;
 
@@ -62,6 +63,18 @@ Gpio::Gpio (cppdb::session & db, long long id) : _db (db), _id (id),
   }
 }
 
+// -----------------------------------------------------------------------------
+uint64_t Gpio::hash() const {
+  Digest d;
+
+  d << _id << _name << _board_family.id() << _board_family.name();
+  for (auto & c : _connector) {
+
+    d << c->number() << c->hash();
+  }
+  return d.value();
+}
+
 // -----------------------------------------------------------------------------
 void Gpio::print (std::ostream& os) const {
   std::string::size_type width = 100;
@@ -17,6 +17,7 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
 #include <iostream>
 #include <cppdb/frontend.h>
 #include "board.h"
@@ -26,6 +27,7 @@ class Gpio {
   public:
     Gpio (cppdb::session & db, long long id);
     void print (std::ostream& os) const;
+    uint64_t hash() const;
 
     inline long long id() const {
       return _id;
@@ -0,0 +1,125 @@
+/* Copyright © 2020 Pascal JEAN, All rights reserved.
+ *
+ * Piduino pidbm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Piduino pidbm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Piduino pidbm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cctype>
+#include "nameindex.h"
+
+using namespace std;
+
+// ---------------------------------------------------------------------------
+//
+//                             NameIndex Class
+//
+// ---------------------------------------------------------------------------
+
+// ---------------------------------------------------------------------------
+static std::string lower (const std::string & s) {
+  string l (s);
+
+  transform (l.begin(), l.end(), l.begin(), ::tolower);
+  return l;
+}
+
+// ---------------------------------------------------------------------------
+// distinct and sorted trigrams of "  name "
+std::vector<uint32_t> NameIndex::trigrams (const std::string & n) {
+  string s = "  " + n + " ";
+  vector<uint32_t> t;
+
+  for (size_t i = 0; i + 3 <= s.size(); i++) {
+
+    t.push_back ( (static_cast<uint8_t> (s[i]) << 16) |
+                  (static_cast<uint8_t> (s[i + 1]) << 8) |
+                  static_cast<uint8_t> (s[i + 2]));
+  }
+  sort (t.begin(), t.end());
+  t.erase (unique (t.begin(), t.end()), t.end());
+  return t;
+}
+
+// ---------------------------------------------------------------------------
+size_t NameIndex::add (const std::string & name) {
+  size_t entry = _names.size();
+  vector<uint32_t> t = trigrams (lower (name));
+
+  _names.push_back (lower (name));
+  _count.push_back (t.size());
+  for (auto g : t) {
+
+    _postings[g].push_back (entry);
+  }
+  return entry;
+}
+
+// ---------------------------------------------------------------------------
+// The hits are sorted by decreasing score, then by entry.
+std::vector<NameIndex::Hit> NameIndex::search (const std::string & term,
+    int minScore) const {
+  string l = lower (term);
+  vector<uint32_t> t = trigrams (l);
+  unordered_map<size_t, size_t> shared; // entry -> shared trigrams
+  vector<Hit> hits;
+
+  for (auto g : t) {
+    auto p = _postings.find (g);
+
+    if (p != _postings.end()) {
+      for (auto e : p->second) {
+        shared[e]++;
+      }
+    }
+  }
+
+  // a term shorter than a trigram can be inside a name without sharing any
+  if (l.size() < 3) {
+
+    for (size_t e = 0; e < _names.size(); e++) {
+      if (_names[e].find (l) != string::npos) {
+        shared.emplace (e, 0);
+      }
+    }
+  }
+
+  for (auto & c : shared) {
+    const string & n = _names[c.first];
+    int score;
+
+    if (n == l) {
+      score = 100;
+    }
+    else if (n.compare (0, l.size(), l) == 0) {
+      score = 90;
+    }
+    else if (n.find (l) != string::npos) {
+      score = 80;
+    }
+    else {
+      // Jaccard similarity of the trigram sets
+      score = static_cast<int> (70 * c.second / (t.size() + _count[c.first] - c.second));
+    }
+
+    if (score >= minScore) {
+
+      hits.push_back ({ c.first, score });
+    }
+  }
+
+  sort (hits.begin(), hits.end(), [] (const Hit & a, const Hit & b) {
+    return a.score > b.score || (a.score == b.score && a.entry < b.entry);
+  });
+  return hits;
+}
+/* ========================================================================== */
@@ -0,0 +1,52 @@
+/* Copyright © 2020 Pascal JEAN, All rights reserved.
+ *
+ * Piduino pidbm is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Piduino pidbm is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Piduino pidbm.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+// In-memory index of names for fuzzy searches, case insensitive.
+// Each name is split in trigrams, padded with spaces as pg_trgm does, and a
+// search scores the names sharing trigrams with the term:
+// 100 equal, 90 prefix, 80 substring, below 70 the trigram similarity.
+class NameIndex {
+  public:
+    class Hit {
+      public:
+        size_t entry; // value returned by add()
+        int score;
+    };
+
+    size_t add (const std::string & name);
+    std::vector<Hit> search (const std::string & term, int minScore = 20) const;
+
+    inline const std::string & name (size_t entry) const {
+      return _names.at (entry);
+    }
+    inline size_t size() const {
+      return _names.size();
+    }
+
+  private:
+    static std::vector<uint32_t> trigrams (const std::string & lowerName);
+
+    std::vector<std::string> _names; // lower case
+    std::vector<size_t> _count; // number of distinct trigrams of each name
+    std::unordered_map<uint32_t, std::vector<size_t>> _postings;
+};
+/* ========================================================================== */
@@ -14,9 +14,11 @@
  * along with Piduino pidbm.  If not, see <http://www.gnu.org/licenses/>.
  */
 #include <exception>
+#include <algorithm>
 #include "pin.h"
 #include "connector.h"
 #include "gpio.h"
+#include "digest.h"
 
 using namespace std;
 
@@ -108,6 +110,86 @@ int Pin::number() const {
   return _parent.pinNumber (_row, _column);
 }
 
+// ---------------------------------------------------------------------------
+// Hash of the pin as seen from its connector: numbers and names in all modes
+uint64_t Pin::hash() const {
+  Digest d;
+  cppdb::result res =
+    _parent.db() << "SELECT pin_mode_id,name "
+    "FROM pin_name "
+    "INNER JOIN pin_has_name ON pin_name_id=pin_name.id "
+    "WHERE pin_id=? "
+    "ORDER BY pin_mode_id"
+    << _id;
+
+  d << _id << _type.id() << static_cast<uint64_t> (_row) << static_cast<uint64_t> (_column)
+    << _gpio_num << _soc_num << _sys_num;
+  while (res.next()) {
+    int mode;
+    string n;
+
+    res >> mode >> n;
+    d << mode << n;
+  }
+  return d.value();
+}
+
+// ---------------------------------------------------------------------------
+std::vector<Pin::Location> Pin::locate (cppdb::session & db, const std::string & name,
+                                        int mode) {
+  vector<Location> locations;
+  string n (name);
+  cppdb::statement st;
+  cppdb::result res;
+
+  transform (n.begin(), n.end(), n.begin(), ::tolower);
+  st = db << "SELECT board.id,board.name,gpio.id,gpio.name,"
+       "connector.id,gpio_has_connector.num,connector.name,"
+       "connector_has_pin.row,connector_has_pin.column,connector_family.columns,"
+       "pin_has_name.pin_id,pin_has_name.pin_mode_id,gpio_has_pin.ino_pin_num "
+       "FROM pin_name "
+       "INNER JOIN pin_has_name ON pin_has_name.pin_name_id=pin_name.id "
+       "INNER JOIN connector_has_pin ON connector_has_pin.pin_id=pin_has_name.pin_id "
+       "INNER JOIN connector ON connector.id=connector_has_pin.connector_id "
+       "INNER JOIN connector_family ON connector_family.id=connector.connector_family_id "
+       "INNER JOIN gpio_has_connector ON gpio_has_connector.connector_id=connector.id "
+       "INNER JOIN gpio ON gpio.id=gpio_has_connector.gpio_id "
+       "LEFT JOIN board ON board.gpio_id=gpio.id "
+       "LEFT JOIN gpio_has_pin ON gpio_has_pin.gpio_id=gpio.id "
+       "AND gpio_has_pin.pin_id=pin_has_name.pin_id "
+       "WHERE lower(pin_name.name)=? AND (?<0 OR pin_has_name.pin_mode_id=?) "
+       "ORDER BY board.name,gpio.name,gpio_has_connector.num,"
+       "connector_has_pin.row,connector_has_pin.column,pin_has_name.pin_mode_id"
+       << n << mode << mode;
+  res = st.query();
+
+  while (res.next()) {
+    Location l;
+    int columns;
+
+    if (!res.fetch (0, l.boardId)) {
+      l.boardId = -1;
+    }
+    res.fetch (1, l.board);
+    res.fetch (2, l.gpioId);
+    res.fetch (3, l.gpio);
+    res.fetch (4, l.connectorId);
+    res.fetch (5, l.connectorNumber);
+    res.fetch (6, l.connector);
+    res.fetch (7, l.row);
+    res.fetch (8, l.column);
+    res.fetch (9, columns);
+    res.fetch (10, l.pinId);
+    res.fetch (11, l.mode);
+    if (!res.fetch (12, l.inoNumber)) {
+      l.inoNumber = -1;
+    }
+    l.number = (l.row - 1) * columns + l.column;
+    locations.push_back (l);
+  }
+  return locations;
+}
+
 // ---------------------------------------------------------------------------
 const std::map<int, std::string> Pin::Type::_names = {
   {Gpio , "Gpio"},
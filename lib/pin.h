@@ -16,7 +16,9 @@
 #pragma once
 
 #include <string>
+#include <cstdint>
 #include <map>
+#include <vector>
 #include <iostream>
 #include <cppdb/frontend.h>
 
@@ -47,11 +49,34 @@ class Pin {
         static const std::map<int, std::string> _names;
     };
 
+    // position of a pin on the connector of a gpio, and the board using it
+    class Location {
+      public:
+        long long boardId; // -1 if no board uses the gpio
+        std::string board;
+        long long gpioId;
+        std::string gpio;
+        long long connectorId;
+        int connectorNumber;
+        std::string connector;
+        size_t row;
+        size_t column;
+        size_t number;
+        long long pinId;
+        int mode;
+        int inoNumber; // -1 if not numbered
+    };
+
     Pin (Connector & parent, long long id, size_t row, size_t column);
     Pin (Connector & parent, const Pin & src);
+    // every position exposing a pin named name (case insensitive), in the
+    // mode if not negative, with a single query
+    static std::vector<Location> locate (cppdb::session & db, const std::string & name,
+                                         int mode = -1);
     void setId (long long i);
     std::string name (int mode = 0) const;
     int number() const;
+    uint64_t hash() const;
 
     inline long long id() const {
       return _id;
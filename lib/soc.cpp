@@ -18,6 +18,7 @@
 #include <algorithm>
 #include <sstream>
 #include "soc.h"
+#include "digest.h"
 
 using namespace std;
 
@@ -138,7 +139,6 @@ Soc::Soc (const Soc & src, const std::string & n) :
   _manufacturer (src._db, src._manufacturer.id()), _i2c_count (src._i2c_count),
   _spi_count (src._spi_count), _uart_count (src._uart_count), _name (n) {
   cppdb::statement st;
-  cppdb::result res;
 
   st = _db << "INSERT INTO soc(name,soc_family_id,manufacturer_id,i2c_count,"
        "spi_count,uart_count) VALUES(?,?,?,?,?,?)"
@@ -147,16 +147,11 @@ Soc::Soc (const Soc & src, const std::string & n) :
   st.exec();
   _id = st.last_insert_id();
 
-  res = _db << "SELECT pin_id FROM soc_has_pin WHERE soc_id=?" << src._id;
-
-  while (res.next()) {
-    long long pin_id;
-
-    res >> pin_id;
-    st = _db << "INSERT INTO soc_has_pin(soc_id,pin_id) VALUES(?,?)"
-         << _id << pin_id;
-    st.exec();
-  }
+  // the pins are copied by the server in a single statement
+  st = _db << "INSERT INTO soc_has_pin(soc_id,pin_id) "
+       "SELECT ?,pin_id FROM soc_has_pin WHERE soc_id=?"
+       << _id << src._id;
+  st.exec();
 }
 
 // -----------------------------------------------------------------------------
@@ -177,4 +172,55 @@ void Soc::setId (long long i) {
   _family.setId (sfid);
   _manufacturer.setId (mid);
 }
+
+// -----------------------------------------------------------------------------
+// Hash of the SoC with its pins, their numbers and their names in all modes
+uint64_t Soc::hash() const {
+  Digest d;
+  cppdb::result res;
+
+  d << _id << _name << _family.id() << _family.name() << _family.arch().name()
+    << _manufacturer.id() << _manufacturer.name()
+    << _i2c_count << _spi_count << _uart_count;
+
+  res = _db << "SELECT soc_has_pin.pin_id,pin_type_id,soc_pin_num,sys_pin_num "
+        "FROM soc_has_pin "
+        "INNER JOIN pin ON pin.id=soc_has_pin.pin_id "
+        "LEFT JOIN pin_number ON pin_number.pin_id=soc_has_pin.pin_id "
+        "WHERE soc_id=? "
+        "ORDER BY soc_has_pin.pin_id"
+        << _id;
+  while (res.next()) {
+    long long pin_id;
+    int type, num;
+
+    res >> pin_id >> type;
+    d << pin_id << type;
+    for (int c = 2; c < 4; c++) {
+      if (res.fetch (c, num)) {
+        d << num;
+      }
+      else {
+        d.addNull();
+      }
+    }
+  }
+
+  res = _db << "SELECT soc_has_pin.pin_id,pin_mode_id,name "
+        "FROM soc_has_pin "
+        "INNER JOIN pin_has_name ON pin_has_name.pin_id=soc_has_pin.pin_id "
+        "INNER JOIN pin_name ON pin_name.id=pin_name_id "
+        "WHERE soc_id=? "
+        "ORDER BY soc_has_pin.pin_id,pin_mode_id"
+        << _id;
+  while (res.next()) {
+    long long pin_id;
+    int mode;
+    string n;
+
+    res >> pin_id >> mode >> n;
+    d << pin_id << mode << n;
+  }
+  return d.value();
+}
 /* ========================================================================== */
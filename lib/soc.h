@@ -16,6 +16,7 @@
 #pragma once
 
 #include <string>
+#include <cstdint>
 #include <iostream>
 #include <cppdb/frontend.h>
 
@@ -84,6 +85,7 @@ class Soc {
     Soc (const Soc & src, const std::string & name);
 
     void setId (long long id);
+    uint64_t hash() const;
 
     inline long long id() const {
       return _id;
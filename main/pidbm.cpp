@@ -18,11 +18,24 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <pwd.h>
+#include <fnmatch.h>
+#include <fstream>
+#include <set>
+#include <bitset>
+#include <functional>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+#include <ctime>
+#include <cstdio>
 #include <configfile.h>
 #include "gpio.h"
 #include "connector.h"
 #include "pin.h"
 #include "soc.h"
+#include "board.h"
+#include "digest.h"
+#include "nameindex.h"
 #include "pidbm_p.h"
 #include "version.h"
 #include "config.h"
@@ -74,6 +87,31 @@ namespace pidbm {
                     std::ptr_fun<int, int> (std::tolower));
     return out;
   }
+
+  // ---------------------------------------------------------------------------
+  // splits a line into words separated by spaces, tabs or commas
+  std::vector<std::string> splitWords (const std::string & line) {
+    std::vector<std::string> words;
+    std::string word;
+
+    for (char c : line) {
+
+      if (c == ' ' || c == '\t' || c == ',' || c == '\r') {
+
+        if (word.size()) {
+          words.push_back (word);
+          word.clear();
+        }
+      }
+      else {
+        word += c;
+      }
+    }
+    if (word.size()) {
+      words.push_back (word);
+    }
+    return words;
+  }
 }
 
 using namespace std;
@@ -110,8 +148,28 @@ Pidbm::open () {
 
     if (d->findConnectionInfo()) {
 
+      if (d->opInMemory) {
+
+        // changes to the copy would be lost
+        d->opReadOnly = true;
+      }
+      if (d->opReadOnly && d->cinfo.compare (0, 8, "sqlite3:") == 0) {
+
+        // no lock taken for writing, the file may even be read-only,
+        // the sessions of the check workers are opened the same way
+        d->cinfo += ";mode=readonly";
+      }
       d->db.open (d->cinfo);
+      if (d->opReadOnly) {
+
+        d->setReadOnly();
+      }
+      d->applySqliteProfile();
       d->checkDatabaseSchemaVersion();
+      if (d->opInMemory) {
+
+        d->loadSnapshot();
+      }
     }
   }
   return isOpen();
@@ -179,6 +237,19 @@ Pidbm::exec () {
     auto args =  d->op.non_option_args();
     if (args.size() > 0) {
 
+      if (d->opReadOnly &&
+          std::find (d->WriteCommands.begin(), d->WriteCommands.end(), args[0]) != d->WriteCommands.end()) {
+
+        throw std::runtime_error (args[0] + " is not allowed in read-only mode");
+      }
+      bool write = std::find (d->WriteCommands.begin(), d->WriteCommands.end(),
+                              args[0]) != d->WriteCommands.end() ||
+                   (args[0] == "index" && args.size() > 1 && args[1] != "list");
+
+      // a write command is atomic, and SQLite syncs only once, the transaction
+      // begins at its first write, after the confirmations
+      std::unique_ptr<Private::Transaction> guard (write ? new Private::Transaction (d) : nullptr);
+
       if (args[0] == "list") {
 
         d->list();
@@ -203,10 +274,82 @@ Pidbm::exec () {
 
         d->copy();
       }
+      else if (args[0] == "gen") {
+
+        d->generate();
+      }
+      else if (args[0] == "check") {
+
+        d->check();
+      }
+      else if (args[0] == "diff") {
+
+        d->diff();
+      }
+      else if (args[0] == "sync") {
+
+        d->sync();
+      }
+      else if (args[0] == "hash") {
+
+        d->hash();
+      }
+      else if (args[0] == "log") {
+
+        d->log();
+      }
+      else if (args[0] == "find") {
+
+        d->find();
+      }
+      else if (args[0] == "index") {
+
+        d->index();
+      }
+      else if (args[0] == "where") {
+
+        d->where();
+      }
+      else if (args[0] == "gc") {
+
+        d->gc();
+      }
+      else if (args[0] == "dedup") {
+
+        d->dedup();
+      }
+      else if (args[0] == "compat") {
+
+        d->compat();
+      }
+      else if (args[0] == "mux") {
+
+        d->mux();
+      }
       else {
 
         throw std::invalid_argument ("invalid command: " + args[0]);
       }
+
+      if (!guard) {
+
+        return;
+      }
+      if (d->opDryRun) {
+
+        if (!d->opQuiet) {
+
+          cout << "Dry run, all changes have been rolled back." << endl;
+        }
+      }
+      else {
+
+        guard->commit();
+        for (auto & sql : d->afterCommit) {
+
+          d->db << sql << cppdb::exec;
+        }
+      }
     }
     else {
 
@@ -255,9 +398,36 @@ Pidbm::warranty () {
 // -----------------------------------------------------------------------------
 // static constants
 const std::string Pidbm::Private::Authors = "Pascal JEAN";
+// lowest limit of the supported backends (SQLITE_MAX_VARIABLE_NUMBER < 3.32)
+const size_t Pidbm::Private::MaxBindParameters = 999;
 const std::string Pidbm::Private::Website = "https://github.com/epsilonrt/pidbm";
+
+// commands rejected in read-only mode
+const std::vector<std::string> Pidbm::Private::WriteCommands = {
+  "add", "mod", "rm", "cp", "gen", "sync", "gc", "dedup"
+};
+
+const std::map<std::string, std::vector<std::string>>
+Pidbm::Private::SqlitePragmas = {
+  { "journal_mode", { "DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF" } },
+  { "synchronous",  { "OFF", "NORMAL", "FULL", "EXTRA", "0", "1", "2", "3" } },
+  { "temp_store",   { "DEFAULT", "FILE", "MEMORY", "0", "1", "2" } },
+  { "mmap_size",    {} },
+  { "cache_size",   {} }, // negative for a size in KiB
+};
+
+const std::map<std::string, std::string>
+Pidbm::Private::SqliteProfiles = {
+  { "default", "" },
+  {
+    "fast",
+    "journal_mode=WAL,synchronous=NORMAL,mmap_size=268435456,"
+    "cache_size=-16384,temp_store=MEMORY"
+  },
+  { "durable", "journal_mode=WAL,synchronous=FULL" },
+};
 const std::string Pidbm::Private::Description =
-  "usage : pidbm [ options ] {list | show | add | cp | mod | rm | {-v | --version} "
+  "usage : pidbm [ options ] {list | show | add | cp | mod | rm | gen | check | diff | sync | hash | log | find | index | where | gc | dedup | compat | mux | {-v | --version} "
   "{-w | --warranty} | {-h | --help}} [<args>] [ options ]\n"
 // 01234567890123456789012345678901234567890123456789012345678901234567890123456789
   "Piduino database manager\n"
@@ -341,22 +511,207 @@ Pidbm::Private::WhatMap = {
   },
 };
 
+const std::vector<Pidbm::Private::ForeignKey>
+Pidbm::Private::ForeignKeys = {
+  { "soc_family",         "arch_id",              "arch" },
+  { "soc",                "soc_family_id",        "soc_family" },
+  { "soc",                "manufacturer_id",      "manufacturer" },
+  { "board_model",        "board_family_id",      "board_family" },
+  { "board_model",        "soc_id",               "soc" },
+  { "gpio",               "board_family_id",      "board_family" },
+  { "board",              "board_model_id",       "board_model" },
+  { "board",              "gpio_id",              "gpio" },
+  { "board",              "manufacturer_id",      "manufacturer" },
+  { "revision",           "board_id",             "board" },
+  { "tag",                "board_id",             "board" },
+  { "connector",          "connector_family_id",  "connector_family" },
+  { "pin",                "pin_type_id",          "pin_type" },
+  { "pin_number",         "pin_id",               "pin" },
+  { "pin_has_name",       "pin_id",               "pin" },
+  { "pin_has_name",       "pin_name_id",          "pin_name" },
+  { "pin_has_name",       "pin_mode_id",          "pin_mode" },
+  { "soc_has_pin",        "soc_id",               "soc" },
+  { "soc_has_pin",        "pin_id",               "pin" },
+  { "connector_has_pin",  "connector_id",         "connector" },
+  { "connector_has_pin",  "pin_id",               "pin" },
+  { "gpio_has_connector", "gpio_id",              "gpio" },
+  { "gpio_has_connector", "connector_id",         "connector" },
+  { "gpio_has_pin",       "gpio_id",              "gpio" },
+  { "gpio_has_pin",       "pin_id",               "pin" },
+};
+
+const std::vector<Pidbm::Private::Table>
+Pidbm::Private::Tables = {
+  { "arch",               { "id" }, { "name" } },
+  { "manufacturer",       { "id" }, { "name" } },
+  { "soc_family",         { "id" }, { "name", "arch_id" } },
+  {
+    "soc",                { "id" }, {
+      "name", "soc_family_id", "manufacturer_id",
+      "i2c_count", "spi_count", "uart_count"
+    }
+  },
+  {
+    "board_family",       { "id" }, {
+      "name", "i2c_syspath", "spi_syspath", "uart_syspath"
+    }
+  },
+  { "board_model",        { "id" }, { "name", "board_family_id", "soc_id" } },
+  { "gpio",               { "id" }, { "name", "board_family_id" } },
+  {
+    "board",              { "id" }, {
+      "name", "board_model_id", "gpio_id", "manufacturer_id", "ram",
+      "pcb_revision", "default_i2c_id", "default_spi_id", "default_uart_id"
+    }
+  },
+  { "revision",           { "board_id", "revision" }, {} },
+  { "tag",                { "board_id", "tag" }, {} },
+  { "connector_family",   { "id" }, { "name", "columns" } },
+  { "connector",          { "id" }, { "name", "rows", "connector_family_id" } },
+  { "pin_type",           { "id" }, { "name" } },
+  { "pin_mode",           { "id" }, { "name" } },
+  { "pin_name",           { "id" }, { "name" } },
+  { "pin",                { "id" }, { "pin_type_id" } },
+  { "pin_number",         { "pin_id" }, { "soc_pin_num", "sys_pin_num" } },
+  { "pin_has_name",       { "pin_id", "pin_name_id", "pin_mode_id" }, {} },
+  { "soc_has_pin",        { "soc_id", "pin_id" }, {} },
+  { "connector_has_pin",  { "connector_id", "row", "column" }, { "pin_id" } },
+  { "gpio_has_connector", { "gpio_id", "num" }, { "connector_id" } },
+  { "gpio_has_pin",       { "gpio_id", "pin_id" }, { "ino_pin_num" } },
+};
+
+// pin_has_name has its primary key, gpio_has_pin and gpio_has_connector
+// include the column not in their primary key
+const std::vector<Pidbm::Private::Table>
+Pidbm::Private::UniqueKeys = {
+  { "board_model",        { "name", "board_family_id", "soc_id" }, {} },
+  { "gpio",               { "name", "board_family_id" }, {} },
+  { "gpio_has_connector", { "gpio_id", "num", "connector_id" }, {} },
+  { "gpio_has_pin",       { "gpio_id", "pin_id", "ino_pin_num" }, {} },
+  { "pin_name",           { "name" }, {} },
+};
+
+// integrity rules run by `check`, orphan rules are added from ForeignKeys
+const std::vector<Pidbm::Private::Rule>
+Pidbm::Private::CheckRules = {
+  {
+    // an alt function may be on several pins, and a SoC reuses the input
+    // names of another one
+    "input pin names shared by several pins of a SoC",
+    "SELECT soc_has_pin.soc_id,pin_name.name,"
+    "COUNT(DISTINCT pin_has_name.pin_id) AS count "
+    "FROM pin_has_name "
+    "INNER JOIN pin_name ON pin_name.id = pin_has_name.pin_name_id "
+    "INNER JOIN soc_has_pin ON soc_has_pin.pin_id = pin_has_name.pin_id "
+    "WHERE pin_has_name.pin_mode_id = 0 "
+    "GROUP BY soc_has_pin.soc_id,pin_name.name "
+    "HAVING COUNT(DISTINCT pin_has_name.pin_id) > 1"
+  },
+  {
+    "duplicate soc_has_pin records",
+    "SELECT soc_id,pin_id,COUNT(*) AS count "
+    "FROM soc_has_pin "
+    "GROUP BY soc_id,pin_id "
+    "HAVING COUNT(*) > 1"
+  },
+  {
+    "duplicate pin_number records",
+    "SELECT pin_id,COUNT(*) AS count "
+    "FROM pin_number "
+    "GROUP BY pin_id "
+    "HAVING COUNT(*) > 1"
+  },
+  {
+    "Gpio pins placed more than once on a connector",
+    "SELECT connector_has_pin.connector_id,pin.id,COUNT(*) AS count "
+    "FROM connector_has_pin "
+    "INNER JOIN pin ON pin.id = connector_has_pin.pin_id "
+    "WHERE pin.pin_type_id = 0 "
+    "GROUP BY connector_has_pin.connector_id,pin.id "
+    "HAVING COUNT(*) > 1"
+  },
+  {
+    "pins numbered more than once in a gpio",
+    "SELECT gpio_id,pin_id,COUNT(*) AS count "
+    "FROM gpio_has_pin "
+    "GROUP BY gpio_id,pin_id "
+    "HAVING COUNT(*) > 1"
+  },
+  {
+    "ino pin numbers used more than once in a gpio",
+    "SELECT gpio_id,ino_pin_num,COUNT(*) AS count "
+    "FROM gpio_has_pin "
+    "GROUP BY gpio_id,ino_pin_num "
+    "HAVING COUNT(*) > 1"
+  },
+  {
+    "connectors whose pin count differs from rows x columns",
+    "SELECT connector.id,connector.name,"
+    "connector.rows * connector_family.columns AS expected,"
+    "COUNT(connector_has_pin.pin_id) AS found "
+    "FROM connector "
+    "INNER JOIN connector_family ON connector_family.id = connector.connector_family_id "
+    "LEFT JOIN connector_has_pin ON connector_has_pin.connector_id = connector.id "
+    "GROUP BY connector.id,connector.name,connector.rows,connector_family.columns "
+    "HAVING COUNT(connector_has_pin.pin_id) <> connector.rows * connector_family.columns"
+  },
+  {
+    "connector pins outside the connector bounds",
+    "SELECT connector.id,connector.name,connector_has_pin.row,connector_has_pin.column "
+    "FROM connector_has_pin "
+    "INNER JOIN connector ON connector.id = connector_has_pin.connector_id "
+    "INNER JOIN connector_family ON connector_family.id = connector.connector_family_id "
+    "WHERE connector_has_pin.row < 1 OR connector_has_pin.row > connector.rows OR "
+    "connector_has_pin.column < 1 OR connector_has_pin.column > connector_family.columns"
+  },
+  {
+    "Gpio pins without pin_number",
+    "SELECT pin.id "
+    "FROM pin "
+    "LEFT JOIN pin_number ON pin_number.pin_id = pin.id "
+    "WHERE pin.pin_type_id = 0 AND pin_number.pin_id IS NULL"
+  },
+  {
+    "pins without name in input mode",
+    "SELECT pin.id,pin.pin_type_id "
+    "FROM pin "
+    "WHERE pin.id NOT IN (SELECT pin_id FROM pin_has_name WHERE pin_mode_id = 0)"
+  },
+};
+
 // -----------------------------------------------------------------------------
 // Constructor
 Pidbm::Private::Private (Pidbm * q) :
-  q_ptr (q), op (Description) {
+  q_ptr (q), op (Description), transactionDepth (0), transactionBegun (false), journalReady (false), journalLocked (false),
+  sqliteVersionNumber (0) {
 
   op.add<Switch> ("h", "help", "Prints this message", &opHelp);
   op.add<Switch> ("v", "version", "Prints version and exit", &opVersion);
   op.add<Switch> ("w", "warranty", "Output the warranty and exit", &opWarranty);
   op.add<Switch> ("q", "quiet", "Perform operations quietly", &opQuiet);
+  op.add<Switch> ("n", "dry-run", "Perform operations then roll back all changes", &opDryRun);
+  op.add<Switch> ("", "read-only", "Open the database in read-only mode, commands that modify "
+                  "it are rejected", &opReadOnly);
+  op.add<Switch> ("", "pivot", "Lists the pins of a SoC with a column per mode", &opPivot);
+  op.add<Switch> ("", "in-memory", "Load the whole database in memory once and work on this copy, "
+                  "implies --read-only", &opInMemory);
   opRevision = op.add<Value<std::string>> ("r", "revision", "Board revision");
   opMemory = op.add<Value<std::string>> ("m", "memory", "Board RAM (MB)");
   opTag = op.add<Value<std::string>> ("t", "tag", "Board tag");
   opPCB = op.add<Value<std::string>> ("p", "pcb", "PCB revision");
   opPinMode = op.add<Implicit<std::string>> ("M", "mode", "Pin mode", "input");
+  opFromFile = op.add<Value<std::string>> ("f", "from-file", "Read the pin list from a file, - for stdin");
+  opOrder = op.add<Value<std::string>> ("", "order", "Pin numbering order, comma separated list of "
+                                        "connector, row, col, soc, sys", "connector,row,col");
+  opSince = op.add<Value<long long>> ("", "since", "Lists the journal entries after this sequence number", 0);
+  opConnectorFamily = op.add<Value<std::string>> ("", "connector-family", "Connector family, "
+                      "with or without its number of rows, h2x or h2x20");
+  opFunctions = op.add<Value<std::string>> ("", "functions", "Comma separated list of the pin functions "
+                "that must match", "i2c,spi,uart");
   op.add<Value<std::string>> ("c", "connection", "Database connection info", "",
                               &cinfo);
+  op.add<Value<std::string>> ("", "sqlite-profile", "SQLite tuning, a profile (default, fast, durable) "
+                              "and/or a comma separated list of pragma=value", "", &sqliteProfile);
 }
 
 // ---------------------------------------------------------------------------
@@ -393,8 +748,10 @@ Pidbm::Private::~Private() {
 
 // add pin2soc
 // 0      soc   (id/name)
-// 1      pin_id/pin_name # name is for pin_mode = 'input'
+// 1+     pin_id/pin_name/first_id-last_id/name_glob # name is for pin_mode = 'input'
 // add pin2soc 3 98
+// add pin2soc 3 98-160 'PA*' PG11
+// add pin2soc 3 -f pins.txt # or from stdin: -f - or pidbm add pin2soc 3 < pins.txt
 // add pin2soc 3 # <<< interactif
 
 // add pin2con
@@ -403,6 +760,7 @@ Pidbm::Private::~Private() {
 // 2          [col]
 // 2/3        pin_id/pin_name # name is for pin_mode = 'input'
 // add pin2con 17  1 1 2
+// add pin2con 17 -f grid.txt # or from stdin: -f - or pidbm add pin2con 17 < grid.txt
 // add pin2con 17 # <<< interactif
 
 // add pin2gpio
@@ -432,6 +790,7 @@ void Pidbm::Private::add() {
 
   if (args.size() > 2) {
     cppdb::result records;
+    cppdb::statement st;
     vector<string> what, v;
     string from, to, where, condition;
 
@@ -462,20 +821,9 @@ void Pidbm::Private::add() {
         }
         pin_type_id = to_string (t);
 
-        n = nameExists ("pin_name", values[1]);
-        if (n >= 0) {
-
-          pin_name_id = to_string (n);
-          if (! opQuiet) {
-            cout <<  "pin_name '" << values[1] << "' found (id:" << pin_name_id << "), nothing to add." << endl;
-          }
-        }
-        else {
-
-          v.push_back (values[1]);
-          n = insertRecord ( { "name" }, "pin_name", v);
-          pin_name_id = to_string (n);
-        }
+        v.push_back (values[1]);
+        n = insertRecord ( { "name" }, "pin_name", v, true);
+        pin_name_id = to_string (n);
 
         what = {"pin.id"};
         from.assign ("pin "
@@ -486,7 +834,7 @@ void Pidbm::Private::add() {
         v.push_back ("0");
         v.push_back (pin_name_id);
         v.push_back (pin_type_id);
-        n = selectRecord (records, what, from, where, v);
+        selectRecord (records, what, from, where, v, "", "", 1);
         if (records.next()) {
 
           records >> pin_id;
@@ -507,7 +855,7 @@ void Pidbm::Private::add() {
           v.push_back (pin_id);
           v.push_back (pin_name_id);
           v.push_back ("0");
-          insertRecord ( { "pin_id", "pin_name_id", "pin_mode_id" }, "pin_has_name", v);
+          insertRecord ( { "pin_id", "pin_name_id", "pin_mode_id" }, "pin_has_name", v, true);
         }
 
         if (t == Pin::Type::Gpio) {
@@ -517,7 +865,7 @@ void Pidbm::Private::add() {
           from = "pin_number";
           what = WhatMap.at (from);
           where = "pin_id";
-          n = selectRecordEqual (records, what, from, where, pin_id);
+          selectRecordEqual (records, what, from, where, pin_id);
 
           if (records.next()) {
 
@@ -559,35 +907,70 @@ void Pidbm::Private::add() {
 
           records >> pin_type_id;
           if (pin_type_id == Pin::Type::Gpio) {
+            vector<long long> modes;
+            vector<string> names;
+            vector<vector<string>> newNames;
+            vector<vector<long long>> rows;
+            std::map<string, long long> nameIds;
+            std::ostringstream req;
+            cppdb::statement st;
+            long long id = stoll (pin_id);
+            long long n;
 
             for (size_t n = 1; n < (values.size() - 1); n += 2) {
-              long long pin_mode_id;
+              long long pin_mode_id = nameExists ("pin_mode", values[n], true);
 
-              pin_mode_id = nameExists ("pin_mode", values[n], true);
-              if (pin_mode_id >= 0) {
-                long long pin_name_id;
+              if (pin_mode_id < 0) {
 
-                v.clear();
-                pin_name_id = nameExists ("pin_name", values[n + 1]);
-                if (pin_name_id < 0) {
+                throw std::invalid_argument (values[n] + " invalid pin mode "
+                                             "name, use `list pin_mode` to see them.");
+              }
+              modes.push_back (pin_mode_id);
+              names.push_back (values[n + 1]);
+              if (nameIds.emplace (values[n + 1], -1).second) {
+                newNames.push_back ({ values[n + 1] });
+              }
+            }
 
-                  v.push_back (values[n + 1]);
-                  pin_name_id = insertRecord ( {"name"}, "pin_name", v);
-                  v.clear();
-                }
-                v.push_back (pin_id);
-                v.push_back (to_string (pin_name_id));
-                v.push_back (to_string (pin_mode_id));
+            // the names, the existing ones are ignored by the backend, then
+            // their ids, then the pin_has_name, one statement each
+            n = insertRecords ( {"name"}, "pin_name", newNames, nullptr, true);
+            if (!opQuiet) {
 
-                insertRecord ( { "pin_id", "pin_name_id", "pin_mode_id" },
-                               "pin_has_name", v, true);
-              }
-              else {
+              cout << n << " pin_name added." << endl;
+            }
+            req << "SELECT id,name FROM pin_name WHERE name IN (";
+            for (size_t i = 0; i < newNames.size(); i++) {
+              req << (i ? ",?" : "?");
+            }
+            req << ')';
+            st = db << req.str();
+            for (auto & name : newNames) {
+              st << name[0];
+            }
+            records = st.query();
+            while (records.next()) {
+              long long name_id;
+              string name;
 
-                throw std::invalid_argument (values[n + 1] + " invalid pin mode "
-                                             "name, use `list pin_mode` to see them.");
+              records >> name_id >> name;
+              nameIds[name] = name_id;
+            }
+
+            for (size_t i = 0; i < names.size(); i++) {
+              vector<long long> row { id, nameIds[names[i]], modes[i] };
+
+              if (std::find (rows.begin(), rows.end(), row) == rows.end()) {
+                rows.push_back (row);
               }
             }
+            n = insertRecords ( { "pin_id", "pin_name_id", "pin_mode_id" }, "pin_has_name",
+                                rows, nullptr, true);
+            if (!opQuiet) {
+
+              cout << n << " names added to the pin " << pin_id << ", "
+                   << (names.size() - n) << " already there." << endl;
+            }
           }
           else {
 
@@ -686,12 +1069,23 @@ void Pidbm::Private::add() {
           }
         }
 
+        vector<vector<string>> rows;
+        long long n;
+
         for (size_t i = 0; i < pv.size(); i++) {
-          string pin_id = pv[i];
-          string ino_pin_num = pn[i];
+          vector<string> row { gpio_id, pv[i], pn[i] };
 
-          v = {  gpio_id, pin_id, ino_pin_num};
-          insertRecord ( { "gpio_id", "pin_id", "ino_pin_num"}, "gpio_has_pin", v, true);
+          if (std::find (rows.begin(), rows.end(), row) == rows.end()) {
+            rows.push_back (row);
+          }
+        }
+        // the existing records are ignored by the backend with gpio_has_pin_uniq
+        n = insertRecords ( { "gpio_id", "pin_id", "ino_pin_num"}, "gpio_has_pin",
+                            rows, nullptr, true);
+        if (!opQuiet) {
+
+          cout << n << " pins added to the gpio " << gpio_id << ", "
+               << (pv.size() - n) << " already there." << endl;
         }
       }
       else {
@@ -703,15 +1097,18 @@ void Pidbm::Private::add() {
     // -------------------------------------------------------------------------
     // add pin2soc
     // 0      soc   (id/name)
-    // 1      pin_id/pin_name # name is for pin_mode = 'input'
+    // 1+     pin_id/pin_name/first_id-last_id/name_glob # name is for pin_mode = 'input'
     // add pin2soc 3 98
+    // add pin2soc 3 98-160 'PA*' PG11
+    // add pin2soc 3 -f pins.txt # or from stdin: -f - or pidbm add pin2soc 3 < pins.txt
     // add pin2soc 3 # <<< interactif
     else if (to == "pin2soc" && values.size() >= 1) {
       string soc_id;
 
       if (readArg (0, "soc", soc_id, true)) {
         string  soc_name;
-        vector<string> pv;
+        vector<string> selectors;
+        vector<long long> pv;
 
         selectRecordEqual (records, {"name"}, "soc", "id", soc_id);
         if (records.next()) {
@@ -719,7 +1116,19 @@ void Pidbm::Private::add() {
           records >> soc_name;
         }
 
-        if (values.size() < 2) {
+        if (values.size() >= 2) {
+
+          selectors.assign (values.begin() + 1, values.end());
+        }
+        else if (opFromFile->is_set() || !isatty (STDIN_FILENO)) {
+
+          for (auto & line : readInputLines()) {
+            vector<string> words = splitWords (line);
+
+            selectors.insert (selectors.end(), words.begin(), words.end());
+          }
+        }
+        else {
           string str;
           bool quit;
 
@@ -734,7 +1143,7 @@ void Pidbm::Private::add() {
             quit = (str == "Q" || str == "q");
 
             if (!quit) {
-              string pin_id;
+              long long pin_id;
 
               if (searchPinId (str, pin_id)) {
 
@@ -748,23 +1157,62 @@ void Pidbm::Private::add() {
           }
           while (!quit);
         }
-        else {
-          string pin_id;
 
-          if (searchPinId (values[1], pin_id)) {
+        if (selectors.size()) {
+          vector<vector<long long>> matches;
 
-            pv.push_back (pin_id);
-          }
-          else {
+          resolvePins (selectors, matches);
+          for (size_t i = 0; i < selectors.size(); i++) {
+
+            if (matches[i].empty()) {
 
-            cout << "pin " << values[1] << " not found !" << endl;
+              cout << "pin " << selectors[i] << " not found !" << endl;
+            }
+            pv.insert (pv.end(), matches[i].begin(), matches[i].end());
           }
         }
 
-        for (auto pin_id : pv) {
+        if (pv.size()) {
+          std::set<long long> existing, added;
+          vector<vector<long long>> rows;
+          long long n = 0;
+          size_t already = 0;
+
+          records = db << "SELECT pin_id FROM soc_has_pin WHERE soc_id=?" << soc_id;
+          while (records.next()) {
+            long long pin_id;
+
+            records >> pin_id;
+            existing.insert (pin_id);
+          }
+
+          for (auto pin_id : pv) {
 
-          v = { pin_id, soc_id };
-          insertRecord ( {"pin_id", "soc_id"}, "soc_has_pin", v, true);
+            if (added.insert (pin_id).second) {
+
+              if (existing.count (pin_id)) {
+
+                already++;
+              }
+              else {
+
+                rows.push_back ({ pin_id, stoll (soc_id) });
+              }
+            }
+          }
+
+          if (rows.size()) {
+            Transaction guard (this);
+
+            n = insertRecords ( {"pin_id", "soc_id"}, "soc_has_pin", rows);
+            guard.commit();
+          }
+
+          if (!opQuiet) {
+
+            cout << n << " pins added to the " << soc_name << " SoC (id:" << soc_id
+                 << "), " << already << " already there." << endl;
+          }
         }
       }
       else {
@@ -780,6 +1228,7 @@ void Pidbm::Private::add() {
     // 2          [col]
     // 2/3        pin_id/pin_name # name is for pin_mode = 'input'
     // add pin2con 17  1 1 2
+    // add pin2con 17 -f grid.txt # or from stdin: -f - or pidbm add pin2con 17 < grid.txt
     // add pin2con 17 # <<< interactif
     else if (to == "pin2con" && values.size() >= 1) {
       long long connector_id;
@@ -803,7 +1252,71 @@ void Pidbm::Private::add() {
             pin_id = stol (values[2], nullptr);
           }
 
+          beginWrite();
           c.updatePin (row, col, pin_id);
+          journal ("connector_has_pin", 'U', "connector_id=" + to_string (c.id()) +
+                   ",row=" + to_string (row) + ",column=" + to_string (col));
+        }
+        else if (opFromFile->is_set() || !isatty (STDIN_FILENO)) {
+          // the whole grid, one line per row, pins separated by space or comma
+          vector<string> lines = readInputLines();
+          vector<string> cells;
+          vector<vector<long long>> matches;
+          vector<vector<long long>> rows;
+          size_t errors = 0;
+
+          if (lines.size() != c.rows()) {
+
+            throw std::invalid_argument ("the " + c.name() + " connector has " +
+                                         to_string (c.rows()) + " rows, " +
+                                         to_string (lines.size()) + " provided.");
+          }
+
+          for (size_t row = 1; row <= lines.size(); row++) {
+            vector<string> words = splitWords (lines[row - 1]);
+
+            if (words.size() != c.columns()) {
+
+              throw std::invalid_argument ("row " + to_string (row) + ": " +
+                                           to_string (words.size()) + " pins provided, " +
+                                           to_string (c.columns()) + " expected.");
+            }
+            cells.insert (cells.end(), words.begin(), words.end());
+          }
+
+          resolvePins (cells, matches);
+          for (size_t i = 0; i < cells.size(); i++) {
+
+            if (matches[i].size() == 1) {
+
+              rows.push_back ({ connector_id, matches[i].front(),
+                                static_cast<long long> (i / c.columns() + 1),
+                                static_cast<long long> (i % c.columns() + 1)
+                              });
+            }
+            else {
+
+              cout << "pin " << cells[i] << (matches[i].empty() ? " not found !" : " is ambiguous !") << endl;
+              errors++;
+            }
+          }
+
+          if (errors) {
+
+            throw std::invalid_argument (to_string (errors) + " pins of the grid could not be resolved, nothing changed.");
+          }
+
+          Transaction guard (this);
+          journalKeys ("connector_has_pin", 'D', "connector_id=?", vector<long long> { connector_id });
+          st = db << "DELETE FROM connector_has_pin WHERE connector_id=?" << connector_id;
+          st.exec();
+          insertRecords ( {"connector_id", "pin_id", "row", "column"}, "connector_has_pin", rows);
+          guard.commit();
+
+          if (!opQuiet) {
+
+            cout << Connector (db, connector_id);
+          }
         }
         else {
           string line;
@@ -854,7 +1367,10 @@ void Pidbm::Private::add() {
 
                 for (size_t col = 1; col <= c.columns() ; col++) {
 
+                  beginWrite();
                   c.updatePin (row, col, pv[col - 1]);
+                  journal ("connector_has_pin", 'U', "connector_id=" + to_string (c.id()) +
+                           ",row=" + to_string (row) + ",column=" + to_string (col));
                 }
                 row++;
               }
@@ -1091,12 +1607,13 @@ void Pidbm::Private::add() {
 // -----------------------------------------------------------------------------
 // Use cases
 
+// rm table [name_like/id] # a table with an id, except pin_type and pin_mode
 // rm board [name_like/id]
 // rm board_model [name_like/id]
-// rm gpio [name_like/id]
-// rm connector [name_like/id]
-// rm manufacturer [name_like/id]
-// rm pin_name [name_like/id]
+// rm board_family nanopi
+// rm pin 98
+// The records that depend on the removed ones, through ForeignKeys, are removed
+// with them, one DELETE per table whatever the number of records.
 void Pidbm::Private::remove() {
 
   auto args =  op.non_option_args();
@@ -1108,59 +1625,124 @@ void Pidbm::Private::remove() {
       string condition;
       string from (args[1]);
       bool like = false;
+      const Table * t = findTable (from);
+      // rows to remove of each table, a condition on the rows of its parents
+      std::map<string, string> selection;
+      vector<const Table *> tables; // children first
+      vector<vector<string>> rows;
+      long long n = 0, dependents = 0;
 
-      if (from == "board") {
-        long long n;
-        cppdb::result records;
-        vector<string> what;
-        vector<string> idList;
+      if (!t || t->key != vector<string> { "id" } ||
+          from == "pin_type" || from == "pin_mode") {
 
-        setWhereCondition (2, where, condition, like);
+        throw std::invalid_argument ("invalid table " + from);
+      }
+      setWhereCondition (2, where, condition, like);
+      if (where == "name" &&
+          std::find (t->columns.begin(), t->columns.end(), "name") == t->columns.end()) {
 
-        what = { "id" };
-        n = selectRecordEqual (records, what, from, where, condition);
+        throw std::invalid_argument (args[2] + " invalid id");
+      }
+      selection[from] = where + (like ? " LIKE ?" : "=?");
 
-        if (n > 0) {
-          string response;
+      // Tables is ordered parents first, the selection of the parents of a
+      // table is complete when it is reached
+      for (auto & c : Tables) {
+        string s;
 
+        for (auto & fk : ForeignKeys) {
 
-          if (opQuiet) {
+          if (fk.table == c.name && c.name != from && selection.count (fk.parent)) {
 
-            response = "Y";
+            s += (s.empty() ? "" : " OR ") + fk.column + " IN (SELECT id FROM " +
+                 fk.parent + " WHERE " + selection[fk.parent] + ")";
           }
-          else {
+        }
+        if (!s.empty()) {
+          selection[c.name] = s;
+        }
+      }
+      for (auto i = Tables.rbegin(); i != Tables.rend(); ++i) {
+
+        if (selection.count (i->name)) {
+          tables.push_back (& (*i));
+        }
+      }
+
+      // the condition is bound once per occurrence in the selection
+      auto conditions = [&] (const string & s) {
+        return vector<string> (std::count (s.begin(), s.end(), '?'), condition);
+      };
+
+      for (auto c : tables) {
+        cppdb::statement st = db << "SELECT COUNT(*) FROM " + c->name + " WHERE " + selection[c->name];
+        cppdb::result res;
+        long long count;
+
+        for (auto & v : conditions (selection[c->name])) {
+          st << v;
+        }
+        res = st.row();
+        res >> count;
+        if (c->name == from) {
+
+          n = count;
+        }
+        else if (count > 0) {
+
+          dependents += count;
+          rows.push_back ({ c->name, to_string (count) });
+        }
+      }
+
+      if (n > 0) {
+        string response;
+
+        if (opQuiet) {
+
+          response = "Y";
+        }
+        else {
+          vector<string> what (t->key);
 
-            printRecordEqual (WhatMap.at ("board"), from, where, condition, like);
-            cout << "Could you confirm the deletion of the " << n << "records above [y/N] ?  ";
-            cin >> response;
+          what.insert (what.end(), t->columns.begin(), t->columns.end());
+          printRecordEqual (what, from, where, condition, like);
+          if (rows.size()) {
+
+            cout << "The records of the following tables depend on them:" << endl;
+            printTable ({ "table", "records" }, rows);
+          }
+          cout << "Could you confirm the deletion of the " << n << " records above";
+          if (dependents) {
+            cout << " and of their " << dependents << " dependent records";
           }
+          cout << " [y/N] ?  ";
+          cin >> response;
+        }
 
-          if (response == "y" || response == "Y") {
-            string id;
-            bool quiet = opQuiet;
+        if (response == "y" || response == "Y") {
+          Transaction guard (this);
 
-            opQuiet = true;
-            while (records.next()) {
+          for (auto c : tables) {
+            const string & s = selection[c->name];
+            cppdb::statement st = db << "DELETE FROM " + c->name + " WHERE " + s;
 
-              records >> id;
-              deleteRecord (what, "revision", "board_id", id);
-              deleteRecord (what, "tag", "board_id", id);
+            journalKeys (c->name, 'D', s, conditions (s));
+            for (auto & v : conditions (s)) {
+              st << v;
             }
+            st.exec();
+          }
+          guard.commit();
+          if (!opQuiet) {
 
-            deleteRecord (what, from, where, condition, like);
-            opQuiet  = quiet;
+            cout << (n + dependents) << " records removed." << endl;
           }
         }
       }
-      else if (from == "board_model" && from == "gpio" && from == "connector" &&
-               from == "manufacturer" && from == "pin_name") {
-
-        setWhereCondition (2, where, condition, like);
-        deleteRecord (WhatMap.at (from), from, where, condition, like);
-      }
-      else {
+      else if (!opQuiet) {
 
-        throw std::invalid_argument ("invalid table " + from);
+        cout << "nothing to remove." << endl;
       }
     }
     else {
@@ -1179,6 +1761,13 @@ void Pidbm::Private::remove() {
 
 // cp connector [name_like/id] new_name
 // cp soc [name_like/id] new_name
+// cp gpio [name_like/id] new_name # with copies of its connectors
+// cp board [name_like/id] new_name [new_gpio_name] {-rREVISION | -tTAG} [-mRAM] [-pPCB_REV]
+// cp board "NanoPi Neo" "NanoPi Neo LTS" -tlts
+// cp board "NanoPi Neo" "NanoPi Neo Core" nanopineocore -tcore -m512
+// The new board shares the gpio of the source board, unless new_gpio_name is
+// given, then it gets a copy of it. The revisions and tags identify a board,
+// they are not copied, the new board needs its own.
 void Pidbm::Private::copy() {
 
   auto args =  op.non_option_args();
@@ -1191,9 +1780,13 @@ void Pidbm::Private::copy() {
       long long connector_id;
 
       if (readArg (0, "connector", connector_id, true)) {
+        Transaction guard (this);
 
         Connector src (db, connector_id);
         Connector dst (src, args[3]);
+        journal ("connector", 'I', "id=" + to_string (dst.id()));
+        journalKeys ("connector_has_pin", 'I', "connector_id=?", vector<long long> { dst.id() });
+        guard.commit();
         if (!opQuiet) {
 
           cout << src.name() << " connector (id:" << src.id() << ") copied to "
@@ -1207,9 +1800,13 @@ void Pidbm::Private::copy() {
       long long soc_id;
 
       if (readArg (0, "soc", soc_id, true)) {
+        Transaction guard (this);
 
         Soc src (db, soc_id);
         Soc dst (src, args[3]);
+        journal ("soc", 'I', "id=" + to_string (dst.id()));
+        journalKeys ("soc_has_pin", 'I', "soc_id=?", vector<long long> { dst.id() });
+        guard.commit();
         if (!opQuiet) {
 
           cout << src.name() << " soc (id:" << src.id() << ") copied to "
@@ -1217,67 +1814,84 @@ void Pidbm::Private::copy() {
         }
       }
     }
-    else {
 
-      throw std::invalid_argument ("invalid item " + to);
-    }
-  }
-  else {
+    // cp gpio [name_like/id] new_name
+    else if (to == "gpio" && args.size() >= 4) {
+      long long gpio_id;
 
-    throw std::invalid_argument ("no argument provided");
-  }
-}
+      if (readArg (0, "gpio", gpio_id, true)) {
+        Transaction guard (this);
+        long long id = copyGpio (gpio_id, args[3]);
 
-// -----------------------------------------------------------------------------
-// Use cases
+        guard.commit();
+        if (!opQuiet) {
 
-// show connector [name_like/id]
-// show gpio [name_like/id]
-void Pidbm::Private::show() {
-  string from;
-  string where;
-  string condition;
-  vector<string> what;
-  bool like = false;
+          cout << Gpio (db, gpio_id).name() << " gpio (id:" << gpio_id << ") copied to "
+               << args[3] << " gpio (id:" << id << ")." << endl;
+        }
+      }
+    }
 
-  auto args =  op.non_option_args();
-
-  if (args.size() > 1) {
+    // cp board [name_like/id] new_name [new_gpio_name] {-rREVISION | -tTAG} [-mRAM] [-pPCB_REV]
+    else if (to == "board" && args.size() >= 4) {
+      long long board_id;
 
-    from = args[1];
-    if (from == "connector" && args.size() > 2) {
-      cppdb::result records;
+      if (opRevision->is_set() == opTag->is_set()) {
 
-      what =  { "id" };
-      setWhereCondition (2, where, condition, like);
+        throw std::invalid_argument ("the new board needs a revision (-r) or a tag (-t)");
+      }
+      if (readArg (0, "board", board_id, true)) {
+        Transaction guard (this);
+        cppdb::result res;
+        cppdb::statement st;
+        string name;
+        long long gpio_id, id;
+
+        res = db << "SELECT name,gpio_id FROM board WHERE id=?" << board_id << cppdb::row;
+        res >> name >> gpio_id;
+        if (args.size() >= 5) {
+
+          gpio_id = copyGpio (gpio_id, args[4]);
+        }
 
-      selectRecordEqual (records, what, from, where, condition, like);
-      while (records.next()) {
-        long long id;
-        records >> id;
-        Connector c (db, id);
+        st = db << string ("INSERT INTO board(name,board_model_id,gpio_id,manufacturer_id,"
+                           "ram,pcb_revision,default_i2c_id,default_spi_id,default_uart_id) "
+                           "SELECT ?,board_model_id,?,manufacturer_id,") +
+             (opMemory->is_set() ? "?" : "ram") + "," +
+             (opPCB->is_set() ? "?" : "pcb_revision") +
+             ",default_i2c_id,default_spi_id,default_uart_id FROM board WHERE id=?";
+        st << args[3] << gpio_id;
+        if (opMemory->is_set()) {
+          st << opMemory->value();
+        }
+        if (opPCB->is_set()) {
+          st << opPCB->value();
+        }
+        st << board_id;
+        st.exec();
+        id = st.last_insert_id();
+        journal ("board", 'I', "id=" + to_string (id));
 
-        cout << c;
-      }
-    }
-    else if (from == "gpio" && args.size() > 2) {
-      cppdb::result records;
+        if (opRevision->is_set()) {
+          long long rev = std::stoll (opRevision->value(), nullptr, 0);
 
-      what =  { "id" };
-      setWhereCondition (2, where, condition, like);
+          insertRecord ( {"board_id", "revision"}, "revision", vector<long long> { id, rev });
+        }
+        else {
 
-      selectRecordEqual (records, what, from, where, condition, like);
-      while (records.next()) {
-        long long id;
-        records >> id;
-        Gpio c (db, id);
+          insertRecord ( {"board_id", "tag"}, "tag", vector<string> { to_string (id), opTag->value() });
+        }
+        guard.commit();
+        if (!opQuiet) {
 
-        cout << c;
+          cout << name << " board (id:" << board_id << ") copied to "
+               << args[3] << " board (id:" << id << ")." << endl;
+        }
       }
     }
     else {
 
-      throw std::invalid_argument ("invalid table " + from);
+      throw std::invalid_argument ("invalid item " + to);
     }
   }
   else {
@@ -1287,75 +1901,128 @@ void Pidbm::Private::show() {
 }
 
 // -----------------------------------------------------------------------------
-// Use cases
+// gen ino gpio [first_ino_pin_num] [--order connector,row,col]
+// gen ino nanopineo
+// gen ino 3 0 --order connector,col,row
+void Pidbm::Private::generate() {
 
-// mod board_family id/name new_name new_i2c_syspath new_spi_syspath new_uart_syspath
-// mod board_model id/name new_name new_board_family_id new_soc_id
-// mod board id/name new_name new_board_model_id new_gpio_id new_manufacturer_id new_ram new_pcb_revision new_default_i2c_id new_default_spi_id new_default_uart_id
-// mod gpio id/name new_name new_board_family_id
-// mod connector id/name new_name new_rows new_connector_family_id
-// mod manufacturer id/name new_name
-// mod pin_type id/name new_name
-// mod pin_mode id/name new_name
-// mod pin_name id/name new_name
-void Pidbm::Private::mod() {
   auto args =  op.non_option_args();
 
   if (args.size() > 1) {
-    string to (args[1]);
+    string what (args[1]);
 
-    if (WhatMap.count (to) > 0 && to == "board_family" && to == "board_model" &&
-        to == "board" && to == "gpio" && to == "connector" &&
-        to == "manufacturer" && to == "pin_type" && to == "pin_mode" &&
-        to == "pin_name") {
+    // gen ino gpio [first_ino_pin_num] [--order connector,row,col]
+    if (what == "ino" && args.size() >= 3) {
+      long long gpio_id;
 
-      if (args.size() > 2) {
-        string where;
-        string c;
-        bool like;
+      if (readArg (0, "gpio", gpio_id, true)) {
+        enum { ConnectorKey, RowKey, ColKey, SocKey, SysKey };
+        const std::map<string, int> keyNames = {
+          {"connector", ConnectorKey}, {"row", RowKey}, {"col", ColKey},
+          {"soc", SocKey}, {"sys", SysKey}
+        };
+        Gpio g (db, gpio_id);
+        vector<int> order;
+        vector<pair<long long, vector<long long>>> pins; // pin_id, sort keys
+        vector<vector<long long>> rows;
+        std::set<long long> numbered;
+        long long ino = 0;
+        long long existing = 0;
+
+        if (args.size() > 3) {
+          std::size_t p = 0;
+
+          ino = stoll (args[3], &p); // thrown exception if not int
+          if (p != args[3].size() || ino < 0) {
+
+            throw std::invalid_argument (args[3] + " invalid pin number.");
+          }
+        }
+
+        for (auto & key : splitWords (opOrder->value())) {
+
+          if (keyNames.count (key) == 0) {
 
-        setWhereCondition (2, where, c, like);
+            throw std::invalid_argument ("invalid order key " + key +
+                                         ", use connector, row, col, soc or sys.");
+          }
+          order.push_back (keyNames.at (key));
+        }
 
-        if (where.size() && c.size()) {
-          vector<string> what;
-          bool wfound = false;
+        for (int i = 0; i < g.size(); i++) {
+          const Connector & c = g.connector (i);
 
-          what = WhatMap.at (to);
+          for (size_t n = 1; n <= c.size(); n++) {
 
-          for (auto w : what) {
-            size_t pos = w.rfind (where);
-            if (pos > 0) {
-              if (w[pos - 1] == '.') {
-                wfound = true;
-              }
+            if (c.hasPin (n) && c.pin (n).type().id() == Pin::Type::Gpio) {
+              const Pin & p = c.pin (n);
+
+              pins.push_back ({ p.id(), {
+                  c.number(), static_cast<long long> (p.row()),
+                  static_cast<long long> (p.column()), p.socNumber(), p.sysNumber()
+                }
+              });
             }
-            else {
-              wfound = true;
+          }
+        }
+
+        std::stable_sort (pins.begin(), pins.end(),
+        [&order] (const pair<long long, vector<long long>> & a, const pair<long long, vector<long long>> & b) {
+          for (int k : order) {
+            if (a.second[k] != b.second[k]) {
+              return a.second[k] < b.second[k];
             }
           }
+          return false;
+        });
+
+        for (auto & p : pins) {
+
+          if (numbered.insert (p.first).second) {
+
+            rows.push_back ({ gpio_id, p.first, ino++ });
+          }
+        }
 
-          if (wfound) {
-            vector<string> values (args.cbegin() + 2, args.cend());
-            vector<string> condition;
+        cppdb::result res = db << "SELECT COUNT(*) FROM gpio_has_pin WHERE gpio_id=?"
+                            << gpio_id << cppdb::row;
+        res >> existing;
+        if (existing > 0 && !opQuiet) {
+          string response;
 
-            condition.push_back (c);
+          cout << "The " << existing << " pins already numbered in the " << g.name()
+               << " Gpio (id:" << gpio_id << ") will be replaced." << endl
+               << "Could you confirm [y/N] ?  ";
+          cin >> response;
+          if (response != "y" && response != "Y") {
 
-            where += "=?";
-            updateRecord (what, to, where, condition, values);
+            return;
           }
         }
 
+        Transaction guard (this);
+        journalKeys ("gpio_has_pin", 'D', "gpio_id=?", vector<long long> { gpio_id });
+        cppdb::statement st = db << "DELETE FROM gpio_has_pin WHERE gpio_id=?" << gpio_id;
+        st.exec();
+        insertRecords ( { "gpio_id", "pin_id", "ino_pin_num"}, "gpio_has_pin", rows);
+        guard.commit();
+
+        if (!opQuiet) {
+
+          cout << Gpio (db, gpio_id) << endl
+               << rows.size() << " pins numbered in the " << g.name() << " Gpio (id:"
+               << gpio_id << ")." << endl;
+        }
       }
       else {
 
-        throw std::invalid_argument ("nothing data provided to modify " + to);
+        throw std::invalid_argument ("invalid gpio " + args[2] + ", use `list gpio` to see them.");
       }
     }
     else {
 
-      throw std::invalid_argument ("invalid table " + to);
+      throw std::invalid_argument ("invalid item " + what);
     }
-
   }
   else {
 
@@ -1364,781 +2031,3292 @@ void Pidbm::Private::mod() {
 }
 
 // -----------------------------------------------------------------------------
-// Use cases
+// check
+// check -q # prints only the rules that failed
+void Pidbm::Private::check() {
+  vector<Rule> rules (CheckRules);
+  vector<vector<string>> header (CheckRules.size() + ForeignKeys.size());
+  vector<vector<vector<string>>> violations (header.size());
+  vector<string> errors (header.size());
+  vector<std::thread> workers;
+  std::atomic<size_t> next (0);
+  size_t failed = 0;
+
+  for (auto & fk : ForeignKeys) {
+
+    rules.push_back ({
+      "orphan " + fk.table + " records (" + fk.column + " not in " + fk.parent + ")",
+      "SELECT " + fk.table + ".* FROM " + fk.table + " WHERE " + fk.column +
+      " NOT IN (SELECT id FROM " + fk.parent + ")"
+    });
+  }
 
-// list board [board_name_like/board_id]
-// list board revision [revision_value]
-// list board tag [tag_value]
+  // each worker takes the next rule and runs it with its own session,
+  // an in-memory copy can only be reached by db, by a single worker
+  size_t njobs = opInMemory ? 1 : std::max (1U, std::thread::hardware_concurrency());
+  njobs = std::min (njobs, rules.size());
+  for (size_t j = 0; j < njobs; j++) {
 
-// list gpio [name_like/id]
-// list gpio pin [gpio_name_like/gpio_id] [-Mpin_mode]
+    workers.emplace_back ([&] () {
+      cppdb::session s;
 
-// list connector [name_like/id]
-// list connector gpio gpio_name_like/gpio_id
-// list connector board board_name_like/board_id
+      for (size_t i = next++; i < rules.size(); i = next++) {
 
-// list pin [pin_name_like/pin_id] [-Mpin_mode]
+        try {
+          cppdb::result res;
 
-// list pin gpio [pin_name_like/pin_id] [-Mpin_mode]
-// list pin net [pin_name_like/pin_id] [-Mpin_mode]
-// list pin audio [pin_name_like/pin_id] [-Mpin_mode]
-// list pin power [pin_name_like/pin_id] [-Mpin_mode]
-// list pin usb [pin_name_like/pin_id] [-Mpin_mode]
-// list pin video [pin_name_like/pin_id] [-Mpin_mode]
-// list pin nc [pin_name_like/pin_id] [-Mpin_mode]
+          if (!s.is_open()) {
+            if (opInMemory) {
+              s = db;
+            }
+            else {
+              s.open (cinfo);
+            }
+          }
+          res = s << rules[i].query;
+          for (int c = 0; c < res.cols(); c++) {
+            header[i].push_back (res.name (c));
+          }
+          while (res.next()) {
+            vector<string> row;
 
-// list pin gpio soc [soc_name_like/soc_id] [-Mpin_mode]
-// list pin net soc [soc_name_like/soc_id] [-Mpin_mode]
-// list pin audio soc [soc_name_like/soc_id] [-Mpin_mode]
-// list pin power soc [soc_name_like/soc_id] [-Mpin_mode]
-// list pin usb soc [soc_name_like/soc_id] [-Mpin_mode]
-// list pin video soc [soc_name_like/soc_id] [-Mpin_mode]
-// list pin nc soc [soc_name_like/soc_id] [-Mpin_mode]
+            for (int c = 0; c < res.cols(); c++) {
+              string value;
 
-// list pin soc 3 [-Mpin_mode]
-// list pin soc H5 [-Mpin_mode]
+              res.fetch (c, value);
+              row.push_back (value);
+            }
+            violations[i].push_back (row);
+          }
+        }
+        catch (std::exception & e) {
 
-// list arch [name_like/id]
-// list soc [name_like/id]
-// list soc_family [name_like/id]
-// list manufacturer [name_like/id]
-// list board_family [name_like/id]
-// list board_model [name_like/id]
-// list connector_family [name_like/id]
-// list pin_type [name_like/id]
-// list pin_mode [name_like/id]
-// list pin_name [name_like/id]
-// list pin_number
-void Pidbm::Private::list() {
+          errors[i] = e.what();
+        }
+      }
+    });
+  }
+  for (auto & w : workers) {
+    w.join();
+  }
 
-  auto args =  op.non_option_args();
+  for (size_t i = 0; i < rules.size(); i++) {
 
-  if (args.size() > 1) {
-    string where;
-    string condition;
-    string orderby;
-    string from (args[1]);
-    vector<string> what;
-    bool like = false;
-    int pos = 2;
+    if (errors[i].size()) {
 
-    if (WhatMap.count (from) > 0) {
-      what = WhatMap.at (from);
+      cout << "[FAIL] " << rules[i].description << ": " << errors[i] << endl;
+      failed++;
     }
+    else if (violations[i].size()) {
 
-    // list board [board_name_like/board_id]
-    // list board revision [revision_value]
-    // list board tag [tag_value]
-    if (from == "board") {
-
-      if (args.size() > 2) {
-        vector<string>::iterator it = what.begin();
+      cout << "[FAIL] " << rules[i].description << ": "
+           << violations[i].size() << " records" << endl;
+      printTable (header[i], violations[i]);
+      failed++;
+    }
+    else if (!opQuiet) {
 
-        if (args[2] == "revision") {
+      cout << "[ OK ] " << rules[i].description << endl;
+    }
+  }
 
-          what.insert (it, "%revision");
-          from.assign ("revision INNER JOIN board ON revision.board_id=board.id");
-          where = "revision";
-          pos = 3;
-        }
-        else if (args[2] == "tag") {
+  // not an integrity failure, but the insertions of these tables are a
+  // select then an insert, that parallel imports can duplicate
+  for (auto & u : UniqueKeys) {
 
-          what.insert (it, "tag");
-          from.assign ("tag INNER JOIN board ON tag.board_id=board.id");
-          where = "tag";
-          pos = 3;
-        }
-      }
+    if (!indexExists (u.name + "_uniq")) {
 
-      setWhereCondition (pos, where, condition, like);
+      cout << "[WARN] " << u.name << "_uniq index missing, the insertions of "
+           << u.name << " are not atomic, use `index create " << u.name << "`" << endl;
     }
+  }
 
-    // list connector [name_like/id]
-    // list connector gpio gpio_name_like/gpio_id
-    // list connector board board_name_like/board_id
-    else if (from == "connector") {
-      string orderby;
-
-      if (args.size() > 3) {
-        string sub_command (args[2]);
-        vector<string>::iterator it = what.begin();
+  if (failed) {
 
-        pos = 3;
-        orderby = "gpio_has_connector.num";
-        it = what.insert (it, "num");
+    throw std::runtime_error (to_string (failed) + " of the " +
+                              to_string (rules.size()) + " integrity rules failed.");
+  }
+  if (!opQuiet) {
 
-        if (sub_command == "gpio") {
+    cout << "All " << rules.size() << " integrity rules passed." << endl;
+  }
+}
 
-          where = "gpio.";
-          from.assign ("connector INNER JOIN gpio_has_connector ON connector_id=connector.id "
-                       "INNER JOIN gpio ON gpio_has_connector.gpio_id=gpio.id");
-        }
-        else if (sub_command == "board") {
+// -----------------------------------------------------------------------------
+// diff cinfo_a [cinfo_b] # cinfo_b is the current database by default
+// diff sqlite3:db=staging.db
+// diff sqlite3:db=staging.db "mysql:database=piduino;user=pi"
+void Pidbm::Private::diff() {
+  auto args =  op.non_option_args();
 
-          where = "board.";
-          from.assign ("connector INNER JOIN gpio_has_connector ON connector_id=connector.id "
-                       "INNER JOIN board ON board.gpio_id=gpio_has_connector.gpio_id");
-        }
-        else {
+  if (args.size() > 1) {
+    cppdb::session a (args[1]);
+    cppdb::session b;
+    vector<Change> changes;
 
-          throw std::invalid_argument ("invalid sub-command " + sub_command);
-        }
-      }
+    checkDatabaseSchemaVersion (a);
+    if (args.size() > 2) {
 
-      setWhereCondition (pos, where, condition, like);
+      b.open (args[2]);
+      checkDatabaseSchemaVersion (b);
     }
+    cppdb::session & other = (args.size() > 2) ? b : db;
 
-    // list pin [pin_name_like/pin_id] [-Mpin_mode]
+    compareDatabases (a, other, changes);
+    for (auto & c : changes) {
 
-    // list pin gpio [pin_name_like/pin_id] [-Mpin_mode]
-    // list pin net [pin_name_like/pin_id] [-Mpin_mode]
-    // list pin audio [pin_name_like/pin_id] [-Mpin_mode]
-    // list pin power [pin_name_like/pin_id] [-Mpin_mode]
-    // list pin usb [pin_name_like/pin_id] [-Mpin_mode]
-    // list pin video [pin_name_like/pin_id] [-Mpin_mode]
-    // list pin nc [pin_name_like/pin_id] [-Mpin_mode]
+      printChange (c);
+    }
+    if (!opQuiet) {
 
-    // list pin gpio soc [soc_name_like/soc_id] [-Mpin_mode]
-    // list pin net soc [soc_name_like/soc_id] [-Mpin_mode]
-    // list pin audio soc [soc_name_like/soc_id] [-Mpin_mode]
-    // list pin power soc [soc_name_like/soc_id] [-Mpin_mode]
-    // list pin usb soc [soc_name_like/soc_id] [-Mpin_mode]
-    // list pin video soc [soc_name_like/soc_id] [-Mpin_mode]
-    // list pin nc soc [soc_name_like/soc_id] [-Mpin_mode]
+      cout << changes.size() << " differences found." << endl;
+    }
+  }
+  else {
 
-    // list pin soc 3 [-Mpin_mode]
-    // list pin soc H5 [-Mpin_mode]
-    else if (from == "pin") {
-      vector<string> cv;
+    throw std::invalid_argument ("no database provided");
+  }
+}
 
-      from.assign ("pin "
-                   "INNER JOIN pin_type on pin_type.id = pin.pin_type_id "
-                   "INNER JOIN pin_has_name on pin.id = pin_has_name.pin_id "
-                   "INNER JOIN pin_name on pin_name.id = pin_has_name.pin_name_id "
-                   "INNER JOIN pin_mode on pin_mode.id = pin_has_name.pin_mode_id "
-                  );
+// -----------------------------------------------------------------------------
+// sync cinfo_src [cinfo_dst] # cinfo_dst is the current database by default
+// sync sqlite3:db=staging.db
+// sync sqlite3:db=staging.db "mysql:database=piduino;user=pi"
+void Pidbm::Private::sync() {
+  auto args =  op.non_option_args();
 
-      what = WhatMap.at ("pin");
+  if (args.size() > 1) {
+    cppdb::session src (args[1]);
+    cppdb::session b;
+    vector<Change> changes;
 
-      if (args.size() > 2) { // pin +
-        string & sub_command = args[2];
+    checkDatabaseSchemaVersion (src);
+    if (args.size() > 2) {
 
-        long long t = nameExists ("pin_type", sub_command, true);
+      b.open (args[2]);
+      checkDatabaseSchemaVersion (b);
+    }
+    cppdb::session & dst = (args.size() > 2) ? b : db;
 
-        if (t >= 0) { // pin + gpio,power,usb,audio,video,nc,net
+    // changes to do on dst to get src
+    if (compareDatabases (dst, src, changes) > 0) {
+      string response;
 
-          if (t == Pin::Type::Gpio) {
-            from.assign ("pin "
-                         "INNER JOIN pin_type on pin_type.id = pin.pin_type_id "
-                         "INNER JOIN pin_has_name on pin.id = pin_has_name.pin_id "
-                         "INNER JOIN pin_name on pin_name.id = pin_has_name.pin_name_id "
-                         "INNER JOIN pin_mode on pin_mode.id = pin_has_name.pin_mode_id "
-                         "INNER JOIN pin_number on pin.id = pin_number.pin_id "
-                         "INNER JOIN gpio_has_pin on pin.id = gpio_has_pin.pin_id "
-                        );
-            what = WhatMap.at ("pin_gpio");
-          }
+      if (opQuiet) {
 
-          if (args.size() > 4) {
+        response = "Y";
+      }
+      else {
 
-            if (args[3] == "soc") {
+        for (auto & c : changes) {
 
-              where = "soc.";
-              setWhereCondition (4, where, condition, like);
-              if (where.size() && condition.size()) {
+          printChange (c);
+        }
+        cout << "Could you confirm the synchronization of the " << changes.size()
+             << " changes above [y/N] ?  ";
+        cin >> response;
+      }
 
-                from += "INNER JOIN soc_has_pin on pin.id = soc_has_pin.pin_id "
-                        "INNER JOIN soc on soc.id = soc_has_pin.soc_id ";
-                where += (like ? " LIKE ? AND " : "=? AND ");
-                cv.push_back (condition);
-              }
+      if (response == "y" || response == "Y") {
 
-            }
-          }
+        if (&dst == &db) {
+          openJournal();
+          Transaction guard (this);
 
-          if (where.empty()) {
+          applyChanges (dst, changes);
+          guard.commit();
+        }
+        else {
 
-            setWhereCondition (3, where, condition, like);
-            if (where.size() && condition.size()) {
-              if (where == "name") {
-                where = "pin_name.name";
-              }
-              else if (where == "id") {
-                where = "pin.id";
-              }
-              where += (like ? " LIKE ? AND " : "=? AND ");
-              cv.push_back (condition);
-            }
-          }
+          // outside of the transaction, the DDL commits implicitly with MySQL
+          createJournal (dst);
+          cppdb::transaction guard (dst);
 
-          where += "pin.pin_type_id=?";
-          cv.push_back (to_string (t));
-          orderby = "pin_name.name";
-        } // <<< pin + gpio,power,usb,audio,video,nc,net
-        else if (sub_command == "soc" && args.size() > 3) { // pin + soc >>>
-          from.assign ("pin "
-                       "INNER JOIN pin_type on pin_type.id = pin.pin_type_id "
-                       "INNER JOIN pin_has_name on pin.id = pin_has_name.pin_id "
-                       "INNER JOIN pin_name on pin_name.id = pin_has_name.pin_name_id "
-                       "INNER JOIN pin_mode on pin_mode.id = pin_has_name.pin_mode_id "
-                       "INNER JOIN soc_has_pin on pin.id = soc_has_pin.pin_id "
-                       "INNER JOIN soc on soc.id = soc_has_pin.soc_id "
-                      );
+          lockJournal (dst);
+          applyChanges (dst, changes);
+          if (!opDryRun) {
 
-          where = "soc.";
-          orderby = "pin_name.name";
-          setWhereCondition (3, where, condition, like);
-          if (where.size() && condition.size()) {
+            guard.commit();
+          }
+          else {
 
-            where += (like ? " LIKE ?" : "=?");
-            cv.push_back (condition);
+            guard.rollback();
           }
-        }  // <<< pin + soc
-      }  // <<< pin +
+          unlockJournal (dst);
+        }
+        if (!opQuiet) {
 
-      if (where.empty()) { // pin only
+          cout << changes.size() << " changes applied." << endl;
+        }
+      }
+    }
+    else if (!opQuiet) {
 
-        setWhereCondition (pos, where, condition, like);
-        orderby = "pin_name.name";
-        if (where.size() && condition.size()) {
+      cout << "Databases are identical, nothing to do." << endl;
+    }
+  }
+  else {
 
-          cv.push_back (condition);
-          if (where == "name") {
+    throw std::invalid_argument ("no database provided");
+  }
+}
 
-            where = "pin_name.name LIKE ?";
-          }
-          else if (where == "id") {
+// -----------------------------------------------------------------------------
+// Compares the tables of a and b with a merge of the records sorted by key,
+// changes receives what must be done on a to get b.
+// Returns the number of changes.
+size_t Pidbm::Private::compareDatabases (cppdb::session & a, cppdb::session & b,
+    std::vector<Change> & changes) {
+
+  auto fetch = [] (cppdb::result & res, Record & r) {
+    bool found = res.next();
+
+    r.values.clear();
+    r.null.clear();
+    if (found) {
+      for (int c = 0; c < res.cols(); c++) {
+        string value;
+
+        r.null.push_back (!res.fetch (c, value));
+        r.values.push_back (value);
+      }
+    }
+    return found;
+  };
 
-            where = "pin.id=?";
+  for (auto & t : Tables) {
+    std::ostringstream req;
+    cppdb::result ra, rb;
+    Record reca, recb;
+    bool hasa, hasb;
+    auto integer = integerColumns (a, t.name);
+
+    req << "SELECT ";
+    for (size_t i = 0; i < t.key.size(); i++) {
+      req << (i ? "," : "") << t.key[i];
+    }
+    for (auto & c : t.columns) {
+      req << ',' << c;
+    }
+    req << " FROM " << t.name << " ORDER BY ";
+
+    ra = a << req.str() + keyOrder (a, t);
+    rb = b << req.str() + keyOrder (b, t);
+    hasa = fetch (ra, reca);
+    hasb = fetch (rb, recb);
+
+    while (hasa || hasb) {
+      int cmp = 0;
+
+      if (!hasa) {
+        cmp = 1;
+      }
+      else if (!hasb) {
+        cmp = -1;
+      }
+      else {
+        // integer keys are compared by value, the others byte-wise as
+        // sorted by keyOrder()
+        for (size_t i = 0; i < t.key.size() && cmp == 0; i++) {
+          const string & ka = reca.values[i];
+          const string & kb = recb.values[i];
+
+          if (integer[t.key[i]]) {
+            long long ia = strtoll (ka.c_str(), nullptr, 10);
+            long long ib = strtoll (kb.c_str(), nullptr, 10);
+
+            cmp = (ia < ib) ? -1 : (ia > ib ? 1 : 0);
+          }
+          else {
+            cmp = ka.compare (kb);
           }
         }
       }
 
-      if (opPinMode->is_set()) {
-        string pin_mode_id;
+      if (cmp < 0) {
 
-        readArg (opPinMode->value(), "pin_mode", pin_mode_id, true);
-        if (pin_mode_id.size()) {
+        changes.push_back ({ &t, '-', reca, Record() });
+        hasa = fetch (ra, reca);
+      }
+      else if (cmp > 0) {
 
-          if (where.size()) {
+        changes.push_back ({ &t, '+', recb, Record() });
+        hasb = fetch (rb, recb);
+      }
+      else {
 
-            where += " AND";
-          }
-          where += " pin_mode.id=?";
-          cv.push_back (pin_mode_id);
+        if (reca.values != recb.values || reca.null != recb.null) {
+
+          changes.push_back ({ &t, '~', recb, reca });
         }
+        hasa = fetch (ra, reca);
+        hasb = fetch (rb, recb);
       }
+    }
+  }
+  return changes.size();
+}
 
-      printRecord (what, from, where, cv, orderby);
-      return; // << --------------------------- return
-    } //-- < pin
+// -----------------------------------------------------------------------------
+// Applies changes computed by compareDatabases(), records are deleted from
+// children to parents, then inserted and updated from parents to children.
+void Pidbm::Private::applyChanges (cppdb::session & s,
+                                   const std::vector<Change> & changes) {
 
-    // list gpio [name_like/id]
-    // list gpio pin [gpio_name_like/gpio_id]  [-Mpin_mode]
-    else if (from == "gpio") {
+  auto key = [] (const Change & c) {
+    std::ostringstream k;
 
-      if (args.size() > 2) { // gpio +
+    for (size_t i = 0; i < c.table->key.size(); i++) {
+      k << (i ? "," : "") << c.table->key[i] << '=' << c.record.values[i];
+    }
+    return k.str();
+  };
+  std::set<const Table *> inserted;
+  auto bind = [] (cppdb::statement & st, const Record & r, size_t first, size_t last) {
+    for (size_t i = first; i < last; i++) {
+      if (r.null[i]) {
+        st.bind_null();
+      }
+      else {
+        st << r.values[i];
+      }
+    }
+  };
 
-        if (args[2] == "pin") {
-          vector<string> cv;
+  for (auto c = changes.crbegin(); c != changes.crend(); ++c) {
 
-          from.assign ("gpio_has_pin "
-                       "INNER JOIN gpio on gpio.id = gpio_has_pin.gpio_id "
-                       "INNER JOIN pin on pin.id = gpio_has_pin.pin_id "
-                       "INNER JOIN pin_type on pin_type.id = pin.pin_type_id "
-                       "INNER JOIN pin_has_name on pin.id = pin_has_name.pin_id "
-                       "INNER JOIN pin_name on pin_name.id = pin_has_name.pin_name_id "
-                       "INNER JOIN pin_mode on pin_mode.id = pin_has_name.pin_mode_id "
-                       "INNER JOIN pin_number on pin.id = pin_number.pin_id "
-                      );
+    if (c->op == '-') {
+      std::ostringstream req;
+      cppdb::statement st;
+
+      req << "DELETE FROM " << c->table->name << " WHERE ";
+      for (size_t i = 0; i < c->table->key.size(); i++) {
+        req << (i ? " AND " : "") << c->table->key[i] << "=?";
+      }
+      st = s << req.str();
+      bind (st, c->record, 0, c->table->key.size());
+      st.exec();
+      journal (s, c->table->name, 'D', { key (*c) });
+    }
+  }
+
+  for (auto & c : changes) {
+    std::ostringstream req;
+    cppdb::statement st;
+    const Table & t = *c.table;
+
+    if (c.op == '+') {
+
+      req << "INSERT INTO " << t.name << "(";
+      for (size_t i = 0; i < t.key.size(); i++) {
+        req << (i ? "," : "") << t.key[i];
+      }
+      for (auto & col : t.columns) {
+        req << ',' << col;
+      }
+      req << ") VALUES(";
+      for (size_t i = 0; i < c.record.values.size(); i++) {
+        req << (i ? ",?" : "?");
+      }
+      req << ')';
+      st = s << req.str();
+      bind (st, c.record, 0, c.record.values.size());
+      st.exec();
+      journal (s, t.name, 'I', { key (c) });
+      inserted.insert (&t);
+    }
+    else if (c.op == '~') {
+
+      req << "UPDATE " << t.name << " SET ";
+      for (size_t i = 0; i < t.columns.size(); i++) {
+        req << (i ? "," : "") << t.columns[i] << "=?";
+      }
+      req << " WHERE ";
+      for (size_t i = 0; i < t.key.size(); i++) {
+        req << (i ? " AND " : "") << t.key[i] << "=?";
+      }
+      st = s << req.str();
+      bind (st, c.record, t.key.size(), c.record.values.size());
+      bind (st, c.record, 0, t.key.size());
+      st.exec();
+      journal (s, t.name, 'U', { key (c) });
+    }
+  }
+
+  if (s.engine() == "postgresql") {
+    // the ids inserted do not advance the SERIAL sequences, the next
+    // insertion without id would get a duplicate key
+    for (auto t : inserted) {
+
+      if (t->key.size() == 1 && t->key[0] == "id") {
+
+        s << "SELECT setval(pg_get_serial_sequence('" + t->name + "','id'),MAX(id)) "
+          "FROM " + t->name << cppdb::row;
+      }
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void Pidbm::Private::printChange (const Change & c, std::ostream & os) {
+  const Table & t = *c.table;
+  auto value = [] (const Record & r, size_t i) {
+    return r.null[i] ? string ("NULL") : r.values[i];
+  };
+
+  os << c.op << ' ' << t.name << " (";
+  for (size_t i = 0; i < t.key.size(); i++) {
+    os << (i ? "," : "") << t.key[i] << '=' << value (c.record, i);
+  }
+  os << ')';
+  for (size_t i = 0; i < t.columns.size(); i++) {
+    size_t j = t.key.size() + i;
+
+    if (c.op != '~') {
+
+      os << (i ? ", " : ": ") << t.columns[i] << '=' << value (c.record, j);
+    }
+    else if (value (c.old, j) != value (c.record, j) || c.old.null[j] != c.record.null[j]) {
+
+      os << ' ' << t.columns[i] << ": " << value (c.old, j) << " -> " << value (c.record, j);
+    }
+  }
+  os << endl;
+}
+
+// -----------------------------------------------------------------------------
+// hash # digest of the whole database, with the digest of each table
+// hash board [name_like/id]
+// hash gpio [name_like/id]
+// hash connector [name_like/id]
+// hash soc [name_like/id]
+void Pidbm::Private::hash() {
+  auto args =  op.non_option_args();
+
+  if (args.size() > 1) {
+    string from = args[1];
+    string where;
+    string condition;
+    bool like = false;
+    cppdb::result records;
+
+    if (from != "board" && from != "gpio" && from != "connector" && from != "soc") {
+
+      throw std::invalid_argument ("invalid table " + from);
+    }
+    if (args.size() > 2) {
+
+      setWhereCondition (2, where, condition, like);
+    }
+    selectRecordEqual (records, { "id" }, from, where, condition, like, "id");
+    while (records.next()) {
+      long long id;
+
+      records >> id;
+      if (from == "board") {
+        Board b (db, id);
+
+        cout << Digest::toString (b.hash()) << "  " << id << "  " << b.name() << endl;
+      }
+      else if (from == "gpio") {
+        Gpio g (db, id);
+
+        cout << Digest::toString (g.hash()) << "  " << id << "  " << g.name() << endl;
+      }
+      else if (from == "connector") {
+        Connector c (db, id);
+
+        cout << Digest::toString (c.hash()) << "  " << id << "  " << c.name() << endl;
+      }
+      else {
+        Soc s (db, id);
+
+        cout << Digest::toString (s.hash()) << "  " << id << "  " << s.name() << endl;
+      }
+    }
+  }
+  else {
+    Digest d;
+
+    for (auto & t : Tables) {
+      uint64_t th = tableHash (db, t);
+
+      d << t.name << th;
+      if (!opQuiet) {
+
+        cout << Digest::toString (th) << "  " << t.name << endl;
+      }
+    }
+    cout << d.toString() << (opQuiet ? "" : "  database") << endl;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// find term # in the names of all tables, the pin names and the board tags
+// find uart1tx
+// find "nanopi neo"
+// The names of all tables are read by a single query then searched in a
+// trigram index, the hits are ranked: 100 equal, 90 prefix, 80 substring,
+// below 70 the trigram similarity.
+void Pidbm::Private::find() {
+  auto args =  op.non_option_args();
+
+  if (args.size() > 1) {
+    std::ostringstream req;
+    cppdb::result res;
+    NameIndex index;
+    vector<vector<string>> entries; // table, id, name, detail
+    vector<vector<string>> rows;
+
+    for (auto & t : Tables) {
+
+      if (t.name != "pin_name" &&
+          std::find (t.columns.begin(), t.columns.end(), "name") != t.columns.end()) {
+
+        req << "SELECT '" << t.name << "',id,name,'' FROM " << t.name << " UNION ALL ";
+      }
+    }
+    req << "SELECT 'pin',pin_has_name.pin_id,pin_name.name,pin_mode.name "
+        "FROM pin_has_name "
+        "INNER JOIN pin_name ON pin_name.id=pin_has_name.pin_name_id "
+        "INNER JOIN pin_mode ON pin_mode.id=pin_has_name.pin_mode_id "
+        "UNION ALL "
+        "SELECT 'board',board_id,tag,'tag' FROM tag";
+
+    res = db << req.str();
+    while (res.next()) {
+      vector<string> e (4);
+
+      for (int c = 0; c < 4; c++) {
+        res.fetch (c, e[c]);
+      }
+      index.add (e[2]);
+      entries.push_back (e);
+    }
+
+    for (auto & hit : index.search (args[1])) {
+      const vector<string> & e = entries[hit.entry];
+
+      rows.push_back ({ to_string (hit.score), e[0], e[1], e[2], e[3] });
+    }
+
+    if (rows.empty()) {
+
+      if (!opQuiet) {
+        cout << "No match for " << args[1] << "." << endl;
+      }
+    }
+    else {
+
+      printTable ({ "score", "table", "id", "name", "detail" }, rows);
+      if (!opQuiet) {
+        cout << rows.size() << " records found." << endl;
+      }
+    }
+  }
+  else {
+
+    throw std::invalid_argument ("no term provided");
+  }
+}
+
+// -----------------------------------------------------------------------------
+// index [list] # tables with a name column, and their index on lower(name)
+//               # tables of UniqueKeys, and their unique index
+// index create [table...] # all these tables by default
+// index drop [table...]
+// The index <table>_lname on lower(name) turns the case insensitive lookups
+// of readArg(), nameExists() and resolvePins(), lower(name)=?, into seeks.
+// It needs SQLite 3.9, PostgreSQL or MySQL 8.0.13.
+// The unique index <table>_uniq lets insertRecord() add a record if it does
+// not exist in one statement, it can not be created on duplicate records.
+void Pidbm::Private::index() {
+  class Index {
+    public:
+      string table;
+      string name;
+      string columns;
+      bool unique;
+  };
+  auto args =  op.non_option_args();
+  string action = args.size() > 1 ? args[1] : "list";
+  vector<Index> indexes;
+
+  if (action != "list" && action != "create" && action != "drop") {
+
+    throw std::invalid_argument ("invalid action " + action);
+  }
+  if (opReadOnly && action != "list") {
+
+    throw std::runtime_error ("index " + action + " is not allowed in read-only mode");
+  }
+
+  for (auto & t : Tables) {
+    bool selected = args.size() <= 2 ||
+                    std::find (args.begin() + 2, args.end(), t.name) != args.end();
+
+    if (selected && std::find (t.columns.begin(), t.columns.end(), "name") != t.columns.end()) {
+
+      // functional key part for MySQL, the double parentheses are required
+      indexes.push_back ({ t.name, t.name + "_lname",
+                           db.engine() == "mysql" ? "(lower(name))" : "lower(name)", false
+                         });
+    }
+    for (auto & u : UniqueKeys) {
+
+      if (selected && u.name == t.name) {
+        string columns;
+
+        for (auto & c : u.key) {
+          columns += (columns.empty() ? "" : ",") + c;
+        }
+        indexes.push_back ({ t.name, t.name + "_uniq", columns, true });
+      }
+    }
+  }
+  for (size_t i = 2; i < args.size(); i++) {
+    bool found = false;
+
+    for (auto & x : indexes) {
+      found = found || x.table == args[i];
+    }
+    if (!found) {
+
+      throw std::invalid_argument ("invalid table " + args[i]);
+    }
+  }
+
+  if (action == "list") {
+    vector<vector<string>> rows;
+    int missing = 0;
+
+    for (auto & i : indexes) {
+
+      rows.push_back ({ i.table, i.name, i.columns, indexExists (i.name) ? "yes" : "no" });
+      if (i.unique && rows.back()[3] == "no") {
+        missing++;
+      }
+    }
+    printTable ({ "table", "index", "columns", "present" }, rows);
+    if (missing) {
+
+      cout << missing << " unique indexes missing, the insertions of their tables are "
+           "a select then an insert, not atomic, use `index create`." << endl;
+    }
+  }
+  else {
+    int n = 0;
+
+    beginWrite();
+    for (auto & i : indexes) {
+      bool exists = indexExists (i.name);
+
+      if (action == "create" && !exists) {
+
+        try {
+          db << "CREATE " + string (i.unique ? "UNIQUE " : "") + "INDEX " +
+             i.name + " ON " + i.table + " (" + i.columns + ")" << cppdb::exec;
+        }
+        catch (cppdb::cppdb_error & e) {
+
+          throw std::runtime_error ("unable to create " + i.name + ", " + e.what() +
+                                    (i.unique ? " (duplicate records ?)" : ""));
+        }
+        n++;
+      }
+      else if (action == "drop" && exists) {
+
+        if (db.engine() == "mysql") {
+          db << "DROP INDEX " + i.name + " ON " + i.table << cppdb::exec;
+        }
+        else {
+          db << "DROP INDEX " + i.name << cppdb::exec;
+        }
+        n++;
+      }
+    }
+    uniqueKeyCache.clear();
+    if (!opQuiet) {
+
+      cout << n << " indexes " << (action == "create" ? "created" : "dropped") << "." << endl;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+// gc # removes the unreferenced records, then VACUUM and ANALYZE
+// The records removed, in one transaction and one DELETE per table, are:
+// - the records of the tables without id whose parent no longer exists,
+// - the pins in no SoC, connector or gpio, with their numbers and names,
+// - the pin names given to no pin.
+void Pidbm::Private::gc() {
+  // table, condition on the rows to remove, in the order of removal
+  vector<std::pair<string, string>> sweeps;
+  vector<vector<string>> rows;
+  long long total = 0;
+  const string unusedPin =
+    "NOT EXISTS (SELECT 1 FROM soc_has_pin WHERE soc_has_pin.pin_id=pin.id) AND "
+    "NOT EXISTS (SELECT 1 FROM connector_has_pin WHERE connector_has_pin.pin_id=pin.id) AND "
+    "NOT EXISTS (SELECT 1 FROM gpio_has_pin WHERE gpio_has_pin.pin_id=pin.id)";
+
+  for (auto t = Tables.rbegin(); t != Tables.rend(); ++t) {
+    string s;
+
+    if (t->key == vector<string> { "id" }) {
+      continue;
+    }
+    for (auto & fk : ForeignKeys) {
+
+      if (fk.table == t->name) {
+
+        s += (s.empty() ? "" : " OR ") + string ("NOT EXISTS (SELECT 1 FROM ") +
+             fk.parent + " WHERE " + fk.parent + ".id=" + t->name + "." + fk.column + ")";
+      }
+    }
+    if (!s.empty()) {
+      sweeps.push_back ({ t->name, s });
+    }
+  }
+  sweeps.push_back ({ "pin_has_name", "pin_id IN (SELECT id FROM pin WHERE " + unusedPin + ")" });
+  sweeps.push_back ({ "pin_number", "pin_id IN (SELECT id FROM pin WHERE " + unusedPin + ")" });
+  sweeps.push_back ({ "pin", unusedPin });
+  sweeps.push_back ({
+    "pin_name",
+    "NOT EXISTS (SELECT 1 FROM pin_has_name WHERE pin_has_name.pin_name_id=pin_name.id)"
+  });
+
+  Transaction guard (this);
+  for (auto & s : sweeps) {
+    cppdb::statement st;
+
+    journalKeys (s.first, 'D', s.second, vector<string>());
+    st = db << "DELETE FROM " + s.first + " WHERE " + s.second;
+    st.exec();
+    if (st.affected() > 0) {
+
+      total += st.affected();
+      rows.push_back ({ s.first, to_string (st.affected()) });
+    }
+  }
+  guard.commit();
+
+  if (db.engine() == "postgresql") {
+
+    afterCommit.push_back ("VACUUM ANALYZE");
+  }
+  else if (db.engine() == "mysql") {
+    string tables;
+
+    for (auto & t : Tables) {
+      tables += (tables.empty() ? "" : ",") + t.name;
+    }
+    afterCommit.push_back ("ANALYZE TABLE " + tables);
+  }
+  else {
+
+    afterCommit.push_back ("VACUUM");
+    afterCommit.push_back ("ANALYZE");
+  }
+
+  if (!opQuiet) {
+
+    if (rows.size()) {
+
+      printTable ({ "table", "removed" }, rows);
+    }
+    cout << total << " unreferenced records removed." << endl;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// dedup connectors # merges the connectors with the same family, rows and pins
+// The signature of a connector is its family, its number of rows and its grid
+// of pin ids, read by a single ordered query. In a group of identical
+// connectors, the one with the lowest id is kept, the gpios using the others
+// are repointed to it, then the others are removed.
+void Pidbm::Private::dedup() {
+  auto args =  op.non_option_args();
+
+  if (args.size() < 2 || args[1] != "connectors") {
+
+    throw std::invalid_argument ("dedup connectors expected");
+  }
+
+  cppdb::result res;
+  std::map<string, vector<long long>> groups;
+  std::map<long long, string> names;
+  vector<vector<string>> rows;
+  string cases, list;
+  long long current = -1, n = 0;
+  std::ostringstream signature;
+
+  res = db << "SELECT connector.id,connector.name,connector.connector_family_id,"
+        "connector.rows,connector_has_pin.row,connector_has_pin.column,connector_has_pin.pin_id "
+        "FROM connector "
+        "INNER JOIN connector_has_pin ON connector_has_pin.connector_id=connector.id "
+        "ORDER BY connector.id,connector_has_pin.row,connector_has_pin.column";
+  while (res.next()) {
+    long long id, family, pin;
+    int nrows, r, c;
+    string name;
+
+    res >> id >> name >> family >> nrows >> r >> c >> pin;
+    if (id != current) {
+
+      if (current >= 0) {
+        groups[signature.str()].push_back (current);
+      }
+      current = id;
+      names[id] = name;
+      signature.str (string());
+      signature << family << ':' << nrows;
+    }
+    signature << ';' << r << ',' << c << ',' << pin;
+  }
+  if (current >= 0) {
+    groups[signature.str()].push_back (current);
+  }
+
+  for (auto & g : groups) {
+    const vector<long long> & ids = g.second;
+
+    for (size_t i = 1; i < ids.size(); i++) {
+
+      cases += " WHEN " + to_string (ids[i]) + " THEN " + to_string (ids[0]);
+      list += (list.empty() ? "" : ",") + to_string (ids[i]);
+      rows.push_back ({ to_string (ids[0]), names[ids[0]], to_string (ids[i]), names[ids[i]] });
+      n++;
+    }
+  }
+
+  if (n == 0) {
+
+    if (!opQuiet) {
+
+      cout << "no duplicate connectors." << endl;
+    }
+    return;
+  }
+
+  if (!opQuiet) {
+    string response;
+
+    printTable ({ "kept id", "kept name", "removed id", "removed name" }, rows);
+    cout << "Could you confirm the removal of the " << n << " duplicate connectors above [y/N] ?  ";
+    cin >> response;
+    if (response != "y" && response != "Y") {
+
+      return;
+    }
+  }
+
+  Transaction guard (this);
+  string in = "connector_id IN (" + list + ")";
+
+  journalKeys ("gpio_has_connector", 'U', in, vector<string>());
+  db << "UPDATE gpio_has_connector SET connector_id=CASE connector_id" + cases + " END WHERE " + in
+     << cppdb::exec;
+  journalKeys ("connector_has_pin", 'D', in, vector<string>());
+  db << "DELETE FROM connector_has_pin WHERE " + in << cppdb::exec;
+  journalKeys ("connector", 'D', "id IN (" + list + ")", vector<string>());
+  db << "DELETE FROM connector WHERE id IN (" + list + ")" << cppdb::exec;
+  guard.commit();
+
+  if (!opQuiet) {
+
+    cout << n << " duplicate connectors removed." << endl;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// compat [--connector-family family] [--functions i2c,spi,uart]
+// compat --connector-family h2x20 # boards pin compatible on a 2x20 header
+// compat --functions i2c,uart
+// The connectors of the boards are grouped in classes of pin compatible
+// connectors: same family and rows, and at each position the same pin type
+// and, for a GPIO, the same functions among those asked, without the bus
+// number (I2C0SDA and I2C1SDA are both I2CSDA). The grouping is done on the
+// digest of this signature, a near-miss is a pair of classes that differ at
+// a single position, found by the digest of the signature without it.
+void Pidbm::Private::compat() {
+  class Unit {
+    public:
+      string board;
+      string connector;
+      string family; // name and rows, h2x20
+      vector<std::pair<int, string>> positions; // pin number, signature
+  };
+  vector<Unit> units;
+  vector<string> functions;
+  string family = opConnectorFamily->is_set() ? toLower (opConnectorFamily->value()) : "";
+  cppdb::result res;
+
+  std::istringstream list (opFunctions->value());
+  for (string f; std::getline (list, f, ',');) {
+
+    if (!f.empty()) {
+      std::transform (f.begin(), f.end(), f.begin(), ::toupper);
+      functions.push_back (f);
+    }
+  }
+
+  // pin names of the functions asked, without the bus number, empty otherwise
+  auto function = [&] (string name) {
+    std::transform (name.begin(), name.end(), name.begin(), ::toupper);
+
+    for (auto & f : functions) {
+
+      if (name.compare (0, f.size(), f) == 0) {
+        size_t end = name.find_first_not_of ("0123456789", f.size());
+
+        return f + (end == string::npos ? "" : name.substr (end));
+      }
+    }
+    return string();
+  };
+
+  res = db << "SELECT board.id,board.name,gpio_has_connector.num,connector.name,"
+        "connector_family.name,connector_family.columns,connector.rows,"
+        "connector_has_pin.row,connector_has_pin.column,pin_type.name,pin_name.name "
+        "FROM board "
+        "INNER JOIN gpio_has_connector ON gpio_has_connector.gpio_id=board.gpio_id "
+        "INNER JOIN connector ON connector.id=gpio_has_connector.connector_id "
+        "INNER JOIN connector_family ON connector_family.id=connector.connector_family_id "
+        "INNER JOIN connector_has_pin ON connector_has_pin.connector_id=connector.id "
+        "INNER JOIN pin ON pin.id=connector_has_pin.pin_id "
+        "INNER JOIN pin_type ON pin_type.id=pin.pin_type_id "
+        "LEFT JOIN pin_has_name ON pin_has_name.pin_id=pin.id "
+        "LEFT JOIN pin_name ON pin_name.id=pin_has_name.pin_name_id "
+        "ORDER BY board.id,gpio_has_connector.num,connector_has_pin.row,connector_has_pin.column";
+
+  long long lastBoard = -1;
+  int lastNum = -1, lastPin = -1;
+  bool selected = false;
+  std::set<string> names;
+
+  // the names of the current position are complete when the next one starts
+  auto flush = [&] () {
+    if (selected && lastPin >= 0) {
+      string sig;
+
+      for (auto & n : names) {
+        sig += (sig.empty() ? "" : "|") + n;
+      }
+      units.back().positions.back().second += sig;
+    }
+    names.clear();
+  };
+
+  while (res.next()) {
+    long long board_id;
+    int num, columns, rows, row, column, pin;
+    string board, connector, fname, type, name;
+
+    res >> board_id >> board >> num >> connector >> fname >> columns >> rows >> row >> column >> type;
+    bool named = res.fetch (10, name);
+    pin = (row - 1) * columns + column;
+
+    if (board_id != lastBoard || num != lastNum) {
+      string f = toLower (fname);
+
+      flush();
+      selected = family.empty() || family == f || family == f + to_string (rows);
+      if (selected) {
+
+        units.push_back ({ board, connector, f + to_string (rows), {} });
+      }
+      lastBoard = board_id;
+      lastNum = num;
+      lastPin = -1;
+    }
+    if (!selected) {
+      continue;
+    }
+    if (pin != lastPin) {
+
+      flush();
+      units.back().positions.push_back ({ pin, type + ":" });
+      lastPin = pin;
+    }
+    if (named) {
+
+      if (type != "gpio") {
+
+        names.insert (name);
+      }
+      else if (!function (name).empty()) {
+
+        names.insert (function (name));
+      }
+    }
+  }
+  flush();
+
+  // classes, in the order of their first connector
+  std::unordered_map<uint64_t, size_t> classOf;
+  vector<vector<size_t>> classes;
+  vector<vector<string>> rows;
+
+  for (size_t u = 0; u < units.size(); u++) {
+    Digest d;
+
+    d << units[u].family;
+    for (auto & p : units[u].positions) {
+      d << p.first << p.second;
+    }
+    auto it = classOf.find (d.value());
+    if (it == classOf.end()) {
+
+      it = classOf.emplace (d.value(), classes.size()).first;
+      classes.push_back ({});
+    }
+    classes[it->second].push_back (u);
+  }
+  for (size_t c = 0; c < classes.size(); c++) {
+
+    for (auto u : classes[c]) {
+      rows.push_back ({ to_string (c + 1), units[u].board, units[u].connector, units[u].family });
+    }
+  }
+  printTable ({ "class", "board", "connector", "family" }, rows);
+  cout << units.size() << " connectors in " << classes.size() << " classes." << endl;
+
+  // near-misses, the classes with the same signature but at one position
+  std::unordered_map<uint64_t, vector<std::pair<size_t, size_t>>> buckets;
+  rows.clear();
+  for (size_t c = 0; c < classes.size(); c++) {
+    const Unit & u = units[classes[c][0]];
+
+    for (size_t i = 0; i < u.positions.size(); i++) {
+      Digest d;
+
+      d << u.family;
+      for (size_t j = 0; j < u.positions.size(); j++) {
+
+        d << u.positions[j].first;
+        if (i == j) {
+          d.addNull();
+        }
+        else {
+          d << u.positions[j].second;
+        }
+      }
+      for (auto & other : buckets[d.value()]) {
+        const Unit & o = units[classes[other.first][0]];
+
+        rows.push_back ({
+          to_string (other.first + 1), to_string (c + 1), to_string (u.positions[i].first),
+          o.positions[i].second + " / " + u.positions[i].second
+        });
+      }
+      buckets[d.value()].push_back ({ c, i });
+    }
+  }
+  if (rows.size()) {
+
+    cout << endl << "Near-misses, classes that differ at a single pin:" << endl;
+    printTable ({ "class", "class", "pin", "difference" }, rows);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// mux board peripheral... # pins and modes to use the peripherals at the same time
+// mux "NanoPi Neo" I2C0 SPI0 UART1
+// mux nanopi UART1TX UART1RX PWM1 # only some signals of a peripheral
+// A peripheral is a prefix of pin names, I2C0 stands for I2C0SDA and I2C0SCK,
+// each signal found on the connectors of the board must get its own pin. The
+// pins of the board are loaded by a single query, the candidate pins of each
+// signal are a bitset, the search assigns first the signal with the fewest
+// free candidates. If there is no solution, the peripherals that can not be
+// used together, or not at all, are given.
+void Pidbm::Private::mux() {
+  static const size_t MaxPins = 256;
+  typedef std::bitset<MaxPins> PinSet;
+  class Signal {
+    public:
+      string peripheral;
+      string name;
+      PinSet pins;
+      vector<std::pair<size_t, string>> candidates; // pin, mode
+  };
+  auto args =  op.non_option_args();
+  long long board_id;
+
+  if (args.size() < 3) {
+
+    throw std::invalid_argument ("a board and at least one peripheral expected");
+  }
+  if (!readArg (args[1], "board", board_id, true)) {
+
+    throw std::invalid_argument ("board " + args[1] + " not found, use `list board` to see them.");
+  }
+
+  vector<string> pinLabels;
+  vector<string> pinNames;
+  vector<std::pair<int, int>> pinPlaces; // connector num, pin number, the first one
+  std::map<long long, size_t> pinIndex; // pin id, a pin may be on several connectors
+  std::map<string, size_t> signalIndex;
+  vector<Signal> signals;
+  vector<string> peripherals;
+  cppdb::result res;
+
+  for (size_t i = 2; i < args.size(); i++) {
+    string p = args[i];
+
+    std::transform (p.begin(), p.end(), p.begin(), ::toupper);
+    peripherals.push_back (p);
+  }
+
+  res = db << "SELECT pin.id,gpio_has_connector.num,connector.name,connector_family.columns,"
+        "connector_has_pin.row,connector_has_pin.column,pin_mode.name,pin_name.name "
+        "FROM board "
+        "INNER JOIN gpio_has_connector ON gpio_has_connector.gpio_id=board.gpio_id "
+        "INNER JOIN connector ON connector.id=gpio_has_connector.connector_id "
+        "INNER JOIN connector_family ON connector_family.id=connector.connector_family_id "
+        "INNER JOIN connector_has_pin ON connector_has_pin.connector_id=connector.id "
+        "INNER JOIN pin ON pin.id=connector_has_pin.pin_id "
+        "INNER JOIN pin_has_name ON pin_has_name.pin_id=pin.id "
+        "INNER JOIN pin_name ON pin_name.id=pin_has_name.pin_name_id "
+        "INNER JOIN pin_mode ON pin_mode.id=pin_has_name.pin_mode_id "
+        "WHERE board.id=? AND pin.pin_type_id=? "
+        "ORDER BY gpio_has_connector.num,connector_has_pin.row,connector_has_pin.column,"
+        "pin_mode.id" << board_id << static_cast<int> (Pin::Type::Gpio);
+  while (res.next()) {
+    long long pin_id;
+    int num, columns, row, column;
+    string connector, mode, name;
+
+    res >> pin_id >> num >> connector >> columns >> row >> column >> mode >> name;
+    int number = (row - 1) * columns + column;
+    auto p = pinIndex.find (pin_id);
+
+    if (p == pinIndex.end()) {
+
+      if (pinLabels.size() == MaxPins) {
+
+        throw std::runtime_error ("too many pins on this board");
+      }
+      p = pinIndex.emplace (pin_id, pinLabels.size()).first;
+      pinPlaces.push_back ({ num, number });
+      pinLabels.push_back (connector + " #" + to_string (number));
+      pinNames.push_back (string());
+    }
+    else if (pinPlaces[p->second] != std::make_pair (num, number)) {
+      // the same pin on another connector, its modes are already known
+      string label = connector + " #" + to_string (number);
+
+      if (pinLabels[p->second].find (label) == string::npos) {
+        pinLabels[p->second] += ", " + label;
+      }
+      continue;
+    }
+    if (mode == "input") {
+      pinNames[p->second] = name;
+    }
+
+    string upper (name);
+    std::transform (upper.begin(), upper.end(), upper.begin(), ::toupper);
+    for (auto & per : peripherals) {
+
+      // UART1 matches UART1TX, not UART10TX
+      bool match = upper.size() >= per.size() &&
+                   upper.compare (0, per.size(), per) == 0 &&
+                   (upper.size() == per.size() || !isdigit (per.back()) ||
+                    !isdigit (upper[per.size()]));
+
+      if (match) {
+        auto s = signalIndex.find (upper);
+
+        if (s == signalIndex.end()) {
+
+          s = signalIndex.emplace (upper, signals.size()).first;
+          signals.push_back ({ per, upper, PinSet(), {} });
+        }
+        signals[s->second].pins.set (p->second);
+        signals[s->second].candidates.push_back ({ p->second, mode });
+        break;
+      }
+    }
+  }
+
+  for (auto & per : peripherals) {
+    bool found = false;
+
+    for (auto & s : signals) {
+      found = found || s.peripheral == per;
+    }
+    if (!found) {
+
+      throw std::invalid_argument (per + " is on no pin of the connectors of " + args[1]);
+    }
+  }
+
+  // search on a subset of the signals, choice[i] is the candidate of signal i
+  vector<int> choice (signals.size(), -1);
+  std::function<bool (const vector<size_t> &, PinSet &, size_t)> solve;
+  solve = [&] (const vector<size_t> & subset, PinSet & used, size_t left) {
+    size_t best = subset.size(), bestCount = MaxPins + 1;
+
+    if (left == 0) {
+      return true;
+    }
+    for (size_t i = 0; i < subset.size(); i++) {
+
+      if (choice[subset[i]] < 0) {
+        size_t count = (signals[subset[i]].pins & ~used).count();
+
+        if (count == 0) {
+          return false;
+        }
+        if (count < bestCount) {
+          best = i;
+          bestCount = count;
+        }
+      }
+    }
+    size_t s = subset[best];
+    for (size_t c = 0; c < signals[s].candidates.size(); c++) {
+      size_t pin = signals[s].candidates[c].first;
+
+      if (!used.test (pin)) {
+
+        used.set (pin);
+        choice[s] = c;
+        if (solve (subset, used, left - 1)) {
+          return true;
+        }
+        used.reset (pin);
+      }
+    }
+    choice[s] = -1;
+    return false;
+  };
+  auto solvable = [&] (const vector<string> & pers) {
+    vector<size_t> subset;
+    PinSet used;
+
+    for (size_t i = 0; i < signals.size(); i++) {
+      if (std::find (pers.begin(), pers.end(), signals[i].peripheral) != pers.end()) {
+        subset.push_back (i);
+      }
+    }
+    std::fill (choice.begin(), choice.end(), -1);
+    return solve (subset, used, subset.size());
+  };
+
+  if (solvable (peripherals)) {
+    vector<vector<string>> rows;
+
+    for (auto & per : peripherals) {
+      for (size_t i = 0; i < signals.size(); i++) {
+
+        if (signals[i].peripheral == per) {
+          auto & c = signals[i].candidates[choice[i]];
+
+          rows.push_back ({ per, signals[i].name, pinLabels[c.first], pinNames[c.first], c.second });
+        }
+      }
+    }
+    printTable ({ "peripheral", "signal", "pin", "gpio", "mode" }, rows);
+    return;
+  }
+
+  // explanation, the peripherals impossible alone, then by pairs
+  vector<string> reasons;
+  for (auto & per : peripherals) {
+
+    if (!solvable ({ per })) {
+      reasons.push_back (per + " can not be used, its signals share the same pins");
+    }
+  }
+  for (size_t i = 0; reasons.empty() && i < peripherals.size(); i++) {
+    for (size_t j = i + 1; j < peripherals.size(); j++) {
+
+      if (!solvable ({ peripherals[i], peripherals[j] })) {
+        PinSet a, b;
+        string shared;
+
+        for (auto & s : signals) {
+          if (s.peripheral == peripherals[i]) {
+            a |= s.pins;
+          }
+          if (s.peripheral == peripherals[j]) {
+            b |= s.pins;
+          }
+        }
+        for (size_t p = 0; p < pinLabels.size(); p++) {
+          if (a.test (p) && b.test (p)) {
+            shared += (shared.empty() ? "" : ", ") + pinLabels[p];
+          }
+        }
+        reasons.push_back (peripherals[i] + " and " + peripherals[j] +
+                           " can not be used together, they share " + shared);
+      }
+    }
+  }
+  if (reasons.empty()) {
+    reasons.push_back ("each pair of peripherals can be used, but not all of them at the same time");
+  }
+  string msg = "no pin assignment for these peripherals on " + args[1];
+  for (auto & r : reasons) {
+    msg += "\n  " + r;
+  }
+  throw std::runtime_error (msg);
+}
+
+// -----------------------------------------------------------------------------
+// where pin_name [--mode=mode] # boards, connectors and physical pins exposing it
+// where PA12
+// where uart1tx --mode=alt2
+// where PA12 -Minput
+void Pidbm::Private::where() {
+  auto args =  op.non_option_args();
+
+  if (args.size() > 1) {
+    long long mode = -1;
+    vector<vector<string>> rows;
+    map<long long, string> modes;
+    cppdb::result res;
+
+    if (opPinMode->is_set() && !readArg (opPinMode->value(), "pin_mode", mode, true)) {
+
+      throw std::invalid_argument ("pin mode " + opPinMode->value() + " not found");
+    }
+
+    res = db << "SELECT id,name FROM pin_mode";
+    while (res.next()) {
+      long long id;
+      string name;
+
+      res >> id >> name;
+      modes[id] = name;
+    }
+
+    for (auto & l : Pin::locate (db, args[1], mode)) {
+
+      rows.push_back ({
+        l.boardId < 0 ? string() : l.board, l.gpio,
+        l.connector + " (#" + to_string (l.connectorNumber) + ")",
+        to_string (l.row), to_string (l.column), to_string (l.number),
+        l.inoNumber < 0 ? string() : to_string (l.inoNumber),
+        to_string (l.pinId), modes[l.mode]
+      });
+    }
+
+    if (rows.empty()) {
+
+      if (!opQuiet) {
+        cout << args[1] << " is not on any connector." << endl;
+      }
+    }
+    else {
+
+      printTable ({ "board", "gpio", "connector", "row", "column", "ph", "ino", "pin_id", "mode" }, rows);
+      if (!opQuiet) {
+        cout << rows.size() << " records found." << endl;
+      }
+    }
+  }
+  else {
+
+    throw std::invalid_argument ("no pin provided");
+  }
+}
+
+// -----------------------------------------------------------------------------
+// log # all the journal entries
+// log --since 1234 # entries after the sequence number 1234
+// Each line is: seq stamp operation table key, separated by tabulations, the
+// stamp is in UTC, the operation is I (insertion), U (update) or D (deletion).
+void Pidbm::Private::log() {
+  cppdb::result res;
+
+  // the journal is created on the first write, it may not exist
+  if (!journalReady) {
+    int n;
+
+    if (db.engine() == "sqlite3") {
+
+      res = db << "SELECT COUNT(*) FROM sqlite_master "
+            "WHERE type='table' AND name='pidbm_journal'" << cppdb::row;
+    }
+    else {
+
+      // the table of the current database, not of another one of the server
+      res = db << "SELECT COUNT(*) FROM information_schema.tables "
+            "WHERE table_name='pidbm_journal' AND table_schema=" +
+            string (db.engine() == "mysql" ? "DATABASE()" : "current_schema()") << cppdb::row;
+    }
+    res >> n;
+    if (n == 0) {
+
+      return;
+    }
+  }
+
+  res = db << "SELECT seq,stamp,operation,table_name,row_key "
+        "FROM pidbm_journal "
+        "WHERE seq>? "
+        "ORDER BY seq" << opSince->value();
+  while (res.next()) {
+    long long seq, stamp;
+    string op, table, key;
+    char buf[32];
+
+    res >> seq >> stamp >> op >> table >> key;
+    time_t t = stamp;
+    strftime (buf, sizeof (buf), "%Y-%m-%dT%H:%M:%SZ", gmtime (&t));
+    cout << seq << '\t' << buf << '\t' << op << '\t' << table << '\t' << key << '\n';
+  }
+  cout.flush();
+}
+
+// -----------------------------------------------------------------------------
+// Columns of table in s, true for an integer one, read from the schema
+std::map<std::string, bool>
+Pidbm::Private::integerColumns (cppdb::session & s, const std::string & table) {
+  std::map<std::string, bool> columns;
+  cppdb::result res;
+
+  if (s.engine() == "sqlite3") {
+
+    res = s << "PRAGMA table_info(" + table + ")";
+    while (res.next()) {
+      string name, type;
+
+      res.fetch (1, name);
+      res.fetch (2, type);
+      std::transform (type.begin(), type.end(), type.begin(), ::toupper);
+      // integer affinity rule of SQLite
+      columns[name] = type.find ("INT") != string::npos;
+    }
+  }
+  else {
+
+    res = s << "SELECT column_name,data_type FROM information_schema.columns "
+          "WHERE table_name=? AND table_schema=" +
+          string (s.engine() == "mysql" ? "DATABASE()" : "current_schema()") << table;
+    while (res.next()) {
+      string name, type;
+
+      res >> name >> type;
+      std::transform (type.begin(), type.end(), type.begin(), ::tolower);
+      columns[name] = type == "tinyint" || type == "smallint" || type == "mediumint" ||
+                      type == "int" || type == "integer" || type == "bigint";
+    }
+  }
+  return columns;
+}
+
+// -----------------------------------------------------------------------------
+// ORDER BY list on the key of t, the text columns are sorted byte-wise
+// whatever the collation of the backend
+std::string Pidbm::Private::keyOrder (cppdb::session & s, const Table & t) {
+  auto integer = integerColumns (s, t.name);
+  std::ostringstream order;
+
+  for (size_t i = 0; i < t.key.size(); i++) {
+    const string & k = t.key[i];
+
+    order << (i ? "," : "");
+    if (integer[k]) {
+      order << k;
+    }
+    else if (s.engine() == "mysql") {
+      order << "BINARY " << k;
+    }
+    else if (s.engine() == "sqlite3") {
+      order << k << " COLLATE BINARY";
+    }
+    else {
+      order << k << " COLLATE \"C\"";
+    }
+  }
+  return order.str();
+}
+
+// -----------------------------------------------------------------------------
+// Hash of all records of t sorted by key, independent of the backend
+uint64_t Pidbm::Private::tableHash (cppdb::session & s, const Table & t) {
+  std::ostringstream req;
+  cppdb::result res;
+  Digest d;
+
+  req << "SELECT ";
+  for (size_t i = 0; i < t.key.size(); i++) {
+    req << (i ? "," : "") << t.key[i];
+  }
+  for (auto & c : t.columns) {
+    req << ',' << c;
+  }
+  req << " FROM " << t.name << " ORDER BY " << keyOrder (s, t);
+
+  res = s << req.str();
+  while (res.next()) {
+
+    for (int c = 0; c < res.cols(); c++) {
+      string value;
+
+      if (res.fetch (c, value)) {
+        d << value;
+      }
+      else {
+        d.addNull();
+      }
+    }
+  }
+  return d.value();
+}
+
+// -----------------------------------------------------------------------------
+// Use cases
+
+// show connector [name_like/id]
+// show gpio [name_like/id]
+// show soc [name_like/id] # the pin x mode matrix of the SoC, by port
+void Pidbm::Private::show() {
+  string from;
+  string where;
+  string condition;
+  vector<string> what;
+  bool like = false;
+
+  auto args =  op.non_option_args();
+
+  if (args.size() > 1) {
+
+    from = args[1];
+    if (from == "connector" && args.size() > 2) {
+      cppdb::result records;
+
+      what =  { "id" };
+      setWhereCondition (2, where, condition, like);
+
+      selectRecordEqual (records, what, from, where, condition, like);
+      while (records.next()) {
+        long long id;
+        records >> id;
+        Connector c (db, id);
+
+        cout << c;
+      }
+    }
+    else if (from == "gpio" && args.size() > 2) {
+      cppdb::result records;
+
+      what =  { "id" };
+      setWhereCondition (2, where, condition, like);
+
+      selectRecordEqual (records, what, from, where, condition, like);
+      while (records.next()) {
+        long long id;
+        records >> id;
+        Gpio c (db, id);
+
+        cout << c;
+      }
+    }
+    else if (from == "soc" && args.size() > 2) {
+      cppdb::result records;
+      vector<std::pair<long long, string>> socs;
+
+      what =  { "id", "name" };
+      setWhereCondition (2, where, condition, like);
+
+      selectRecordEqual (records, what, from, where, condition, like);
+      while (records.next()) {
+        long long id;
+        string name;
+
+        records >> id >> name;
+        socs.push_back ({ id, name });
+      }
+      for (auto & soc : socs) {
+
+        printPinModeMatrix (soc.first, soc.second);
+      }
+    }
+    else {
+
+      throw std::invalid_argument ("invalid table " + from);
+    }
+  }
+  else {
+
+    throw std::invalid_argument ("no argument provided");
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Use cases
+
+// mod table filter... set column=value... # a single UPDATE of all the matching records
+//   filter: column op value, op is =, !=, <, >, <=, >= or ~ (LIKE, with * and ?),
+//   a comma separated list of values with = or != is a IN list,
+//   a filter without operator is an id or a name (LIKE), an empty value is NULL
+// mod board "name~NanoPi Neo*" set board_model_id=5
+// mod board id=10,11,12 set gpio_id=4 default_uart_id=
+// mod connector connector_family_id=2 "rows>10" set connector_family_id=3
+// Legacy form, the new values of the columns in the order of the table:
+// mod board_family id/name new_name new_i2c_syspath new_spi_syspath new_uart_syspath
+// mod board_model id/name new_name new_board_family_id new_soc_id
+// mod board id/name new_name new_board_model_id new_gpio_id new_manufacturer_id new_ram new_pcb_revision new_default_i2c_id new_default_spi_id new_default_uart_id
+// mod gpio id/name new_name new_board_family_id
+// mod connector id/name new_name new_rows new_connector_family_id
+// mod manufacturer id/name new_name
+// mod pin_type id/name new_name
+// mod pin_mode id/name new_name
+// mod pin_name id/name new_name
+void Pidbm::Private::mod() {
+  auto args =  op.non_option_args();
+
+  if (args.size() > 1) {
+    string to (args[1]);
+    const Table * t = findTable (to);
+    vector<string> columns;
+    vector<string> set;
+    vector<string> values;
+    vector<string> condition;
+    string where;
+
+    if (!t) {
+
+      throw std::invalid_argument ("invalid table " + to);
+    }
+    columns = t->key;
+    columns.insert (columns.end(), t->columns.begin(), t->columns.end());
+
+    auto column = [&] (string c) {
+      size_t pos = c.rfind ('.');
+
+      if (pos != string::npos && c.substr (0, pos) == to) {
+        c.erase (0, pos + 1);
+      }
+      if (std::find (columns.begin(), columns.end(), c) == columns.end()) {
+
+        throw std::invalid_argument (c + " is not a column of " + to);
+      }
+      return c;
+    };
+
+    auto filter = [&] (const string & f) {
+      static const vector<string> ops = { "!=", "<=", ">=", "=", "<", ">", "~" };
+      size_t pos = f.find_first_of ("!<>=~");
+      string w;
+
+      for (auto & o : ops) {
+
+        if (pos != string::npos && pos > 0 && f.compare (pos, o.size(), o) == 0) {
+          string c = column (f.substr (0, pos));
+          string v = f.substr (pos + o.size());
+
+          if (o == "~") {
+
+            std::replace (v.begin(), v.end(), '*', '%');
+            std::replace (v.begin(), v.end(), '?', '_');
+            w = c + " LIKE ?";
+            condition.push_back (v);
+          }
+          else if ( (o == "=" || o == "!=") && v.find (',') != string::npos) {
+            std::istringstream list (v);
+            string item;
+
+            w = c + (o == "=" ? " IN (" : " NOT IN (");
+            while (std::getline (list, item, ',')) {
+
+              w += (w.back() == '(' ? "?" : ",?");
+              condition.push_back (item);
+            }
+            w += ')';
+          }
+          else {
+
+            w = c + o + "?";
+            condition.push_back (v);
+          }
+          break;
+        }
+      }
+
+      if (w.empty()) {
+        string c;
+        bool like = false;
+
+        setWhereCondition (f, w, c, like);
+        w = column (w) + (like ? " LIKE ?" : "=?");
+        condition.push_back (c);
+      }
+      where += (where.empty() ? "" : " AND ") + w;
+    };
+
+    auto s = std::find (args.begin() + 2, args.end(), "set");
+    if (s != args.end()) {
+
+      for (auto i = args.begin() + 2; i != s; ++i) {
+        filter (*i);
+      }
+      for (auto i = s + 1; i != args.end(); ++i) {
+        size_t eq = i->find ('=');
+
+        if (eq == string::npos) {
+
+          throw std::invalid_argument (*i + " invalid assignment, column=value expected");
+        }
+        set.push_back (column (i->substr (0, eq)));
+        values.push_back (i->substr (eq + 1));
+      }
+    }
+    else if (args.size() > 3) {
+
+      filter (args[2]);
+      values.assign (args.begin() + 3, args.end());
+      if (values.size() > t->columns.size()) {
+
+        throw std::invalid_argument ("too many values to modify " + to);
+      }
+      set.assign (t->columns.begin(), t->columns.begin() + values.size());
+    }
+    else {
+
+      throw std::invalid_argument ("nothing data provided to modify " + to);
+    }
+
+    if (where.empty()) {
+
+      throw std::invalid_argument ("a filter is required, id>0 to modify all the records");
+    }
+    if (set.empty()) {
+
+      throw std::invalid_argument ("nothing to set in " + to);
+    }
+
+    if (!opQuiet) {
+      string response;
+      long long n = printRecord (columns, to, where, condition);
+
+      if (n == 0) {
+
+        return;
+      }
+      cout << "Could you confirm the modification of the " << n << " records above [y/N] ?  ";
+      cin >> response;
+      if (response != "y" && response != "Y") {
+
+        return;
+      }
+    }
+
+    std::ostringstream req;
+    cppdb::statement st;
+    Transaction guard (this);
+
+    req << "UPDATE " << to << " SET ";
+    for (size_t i = 0; i < set.size(); i++) {
+
+      req << (i ? "," : "") << set[i] << "=?";
+    }
+    req << " WHERE " << where;
+    //cout << req.str() << endl; // debug
+
+    journalKeys (to, 'U', where, condition);
+    st = db << req.str();
+    for (auto & v : values) {
+
+      if (v.empty()) {
+        st.bind_null();
+      }
+      else {
+        st << v;
+      }
+    }
+    for (auto & c : condition) {
+      st << c;
+    }
+    st.exec();
+    guard.commit();
+
+    if (!opQuiet) {
+
+      cout << st.affected() << " records updated in " << to << "." << endl;
+    }
+  }
+  else {
+
+    throw std::invalid_argument ("no argument provided");
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Use cases
+
+// list board [board_name_like/board_id]
+// list board revision [revision_value]
+// list board tag [tag_value]
+
+// list gpio [name_like/id]
+// list gpio pin [gpio_name_like/gpio_id] [-Mpin_mode]
+
+// list connector [name_like/id]
+// list connector gpio gpio_name_like/gpio_id
+// list connector board board_name_like/board_id
+
+// list pin [pin_name_like/pin_id] [-Mpin_mode]
+
+// list pin gpio [pin_name_like/pin_id] [-Mpin_mode]
+// list pin net [pin_name_like/pin_id] [-Mpin_mode]
+// list pin audio [pin_name_like/pin_id] [-Mpin_mode]
+// list pin power [pin_name_like/pin_id] [-Mpin_mode]
+// list pin usb [pin_name_like/pin_id] [-Mpin_mode]
+// list pin video [pin_name_like/pin_id] [-Mpin_mode]
+// list pin nc [pin_name_like/pin_id] [-Mpin_mode]
+
+// list pin gpio soc [soc_name_like/soc_id] [-Mpin_mode]
+// list pin net soc [soc_name_like/soc_id] [-Mpin_mode]
+// list pin audio soc [soc_name_like/soc_id] [-Mpin_mode]
+// list pin power soc [soc_name_like/soc_id] [-Mpin_mode]
+// list pin usb soc [soc_name_like/soc_id] [-Mpin_mode]
+// list pin video soc [soc_name_like/soc_id] [-Mpin_mode]
+// list pin nc soc [soc_name_like/soc_id] [-Mpin_mode]
+
+// list pin soc 3 [-Mpin_mode]
+// list pin soc H5 [-Mpin_mode]
+// list pin soc H5 --pivot # a row per pin, a column per mode
+
+// list arch [name_like/id]
+// list soc [name_like/id]
+// list soc_family [name_like/id]
+// list manufacturer [name_like/id]
+// list board_family [name_like/id]
+// list board_model [name_like/id]
+// list connector_family [name_like/id]
+// list pin_type [name_like/id]
+// list pin_mode [name_like/id]
+// list pin_name [name_like/id]
+// list pin_number
+void Pidbm::Private::list() {
+
+  auto args =  op.non_option_args();
+
+  if (args.size() > 1) {
+    string where;
+    string condition;
+    string orderby;
+    string from (args[1]);
+    vector<string> what;
+    bool like = false;
+    int pos = 2;
+
+    if (WhatMap.count (from) > 0) {
+      what = WhatMap.at (from);
+    }
+
+    // list board [board_name_like/board_id]
+    // list board revision [revision_value]
+    // list board tag [tag_value]
+    if (from == "board") {
+
+      if (args.size() > 2) {
+        vector<string>::iterator it = what.begin();
+
+        if (args[2] == "revision") {
+
+          what.insert (it, "%revision");
+          from.assign ("revision INNER JOIN board ON revision.board_id=board.id");
+          where = "revision";
+          pos = 3;
+        }
+        else if (args[2] == "tag") {
+
+          what.insert (it, "tag");
+          from.assign ("tag INNER JOIN board ON tag.board_id=board.id");
+          where = "tag";
+          pos = 3;
+        }
+      }
+
+      setWhereCondition (pos, where, condition, like);
+    }
+
+    // list connector [name_like/id]
+    // list connector gpio gpio_name_like/gpio_id
+    // list connector board board_name_like/board_id
+    else if (from == "connector") {
+      string orderby;
+
+      if (args.size() > 3) {
+        string sub_command (args[2]);
+        vector<string>::iterator it = what.begin();
+
+        pos = 3;
+        orderby = "gpio_has_connector.num";
+        it = what.insert (it, "num");
+
+        if (sub_command == "gpio") {
+
+          where = "gpio.";
+          from.assign ("connector INNER JOIN gpio_has_connector ON connector_id=connector.id "
+                       "INNER JOIN gpio ON gpio_has_connector.gpio_id=gpio.id");
+        }
+        else if (sub_command == "board") {
+
+          where = "board.";
+          from.assign ("connector INNER JOIN gpio_has_connector ON connector_id=connector.id "
+                       "INNER JOIN board ON board.gpio_id=gpio_has_connector.gpio_id");
+        }
+        else {
+
+          throw std::invalid_argument ("invalid sub-command " + sub_command);
+        }
+      }
+
+      setWhereCondition (pos, where, condition, like);
+    }
+
+    // list pin [pin_name_like/pin_id] [-Mpin_mode]
+
+    // list pin gpio [pin_name_like/pin_id] [-Mpin_mode]
+    // list pin net [pin_name_like/pin_id] [-Mpin_mode]
+    // list pin audio [pin_name_like/pin_id] [-Mpin_mode]
+    // list pin power [pin_name_like/pin_id] [-Mpin_mode]
+    // list pin usb [pin_name_like/pin_id] [-Mpin_mode]
+    // list pin video [pin_name_like/pin_id] [-Mpin_mode]
+    // list pin nc [pin_name_like/pin_id] [-Mpin_mode]
+
+    // list pin gpio soc [soc_name_like/soc_id] [-Mpin_mode]
+    // list pin net soc [soc_name_like/soc_id] [-Mpin_mode]
+    // list pin audio soc [soc_name_like/soc_id] [-Mpin_mode]
+    // list pin power soc [soc_name_like/soc_id] [-Mpin_mode]
+    // list pin usb soc [soc_name_like/soc_id] [-Mpin_mode]
+    // list pin video soc [soc_name_like/soc_id] [-Mpin_mode]
+    // list pin nc soc [soc_name_like/soc_id] [-Mpin_mode]
+
+    // list pin soc 3 [-Mpin_mode]
+    // list pin soc H5 [-Mpin_mode]
+    else if (from == "pin") {
+      vector<string> cv;
+
+      from.assign ("pin "
+                   "INNER JOIN pin_type on pin_type.id = pin.pin_type_id "
+                   "INNER JOIN pin_has_name on pin.id = pin_has_name.pin_id "
+                   "INNER JOIN pin_name on pin_name.id = pin_has_name.pin_name_id "
+                   "INNER JOIN pin_mode on pin_mode.id = pin_has_name.pin_mode_id "
+                  );
+
+      what = WhatMap.at ("pin");
+
+      if (args.size() > 2) { // pin +
+        string & sub_command = args[2];
+
+        long long t = nameExists ("pin_type", sub_command, true);
+
+        if (t >= 0) { // pin + gpio,power,usb,audio,video,nc,net
+
+          if (t == Pin::Type::Gpio) {
+            from.assign ("pin "
+                         "INNER JOIN pin_type on pin_type.id = pin.pin_type_id "
+                         "INNER JOIN pin_has_name on pin.id = pin_has_name.pin_id "
+                         "INNER JOIN pin_name on pin_name.id = pin_has_name.pin_name_id "
+                         "INNER JOIN pin_mode on pin_mode.id = pin_has_name.pin_mode_id "
+                         "INNER JOIN pin_number on pin.id = pin_number.pin_id "
+                         "INNER JOIN gpio_has_pin on pin.id = gpio_has_pin.pin_id "
+                        );
+            what = WhatMap.at ("pin_gpio");
+          }
+
+          if (args.size() > 4) {
+
+            if (args[3] == "soc") {
+
+              where = "soc.";
+              setWhereCondition (4, where, condition, like);
+              if (where.size() && condition.size()) {
+
+                from += "INNER JOIN soc_has_pin on pin.id = soc_has_pin.pin_id "
+                        "INNER JOIN soc on soc.id = soc_has_pin.soc_id ";
+                where += (like ? " LIKE ? AND " : "=? AND ");
+                cv.push_back (condition);
+              }
+
+            }
+          }
+
+          if (where.empty()) {
+
+            setWhereCondition (3, where, condition, like);
+            if (where.size() && condition.size()) {
+              if (where == "name") {
+                where = "pin_name.name";
+              }
+              else if (where == "id") {
+                where = "pin.id";
+              }
+              where += (like ? " LIKE ? AND " : "=? AND ");
+              cv.push_back (condition);
+            }
+          }
+
+          where += "pin.pin_type_id=?";
+          cv.push_back (to_string (t));
+          orderby = "pin_name.name";
+        } // <<< pin + gpio,power,usb,audio,video,nc,net
+        else if (sub_command == "soc" && args.size() > 3) { // pin + soc >>>
+          from.assign ("pin "
+                       "INNER JOIN pin_type on pin_type.id = pin.pin_type_id "
+                       "INNER JOIN pin_has_name on pin.id = pin_has_name.pin_id "
+                       "INNER JOIN pin_name on pin_name.id = pin_has_name.pin_name_id "
+                       "INNER JOIN pin_mode on pin_mode.id = pin_has_name.pin_mode_id "
+                       "INNER JOIN soc_has_pin on pin.id = soc_has_pin.pin_id "
+                       "INNER JOIN soc on soc.id = soc_has_pin.soc_id "
+                      );
+
+          where = "soc.";
+          orderby = "pin_name.name";
+          setWhereCondition (3, where, condition, like);
+          if (where.size() && condition.size()) {
+
+            where += (like ? " LIKE ?" : "=?");
+            cv.push_back (condition);
+          }
+
+          if (opPivot) {
+            cppdb::result records;
+            vector<std::pair<long long, string>> socs;
+
+            selectRecord (records, {"soc.id", "soc.name"}, "soc", where, cv);
+            while (records.next()) {
+              long long id;
+              string name;
+
+              records >> id >> name;
+              socs.push_back ({ id, name });
+            }
+            for (auto & soc : socs) {
+
+              printPinModeMatrix (soc.first, soc.second);
+            }
+            return; // << --------------------------- return
+          }
+        }  // <<< pin + soc
+      }  // <<< pin +
+
+      if (where.empty()) { // pin only
+
+        setWhereCondition (pos, where, condition, like);
+        orderby = "pin_name.name";
+        if (where.size() && condition.size()) {
+
+          cv.push_back (condition);
+          if (where == "name") {
+
+            where = "pin_name.name LIKE ?";
+          }
+          else if (where == "id") {
+
+            where = "pin.id=?";
+          }
+        }
+      }
+
+      if (opPinMode->is_set()) {
+        string pin_mode_id;
+
+        readArg (opPinMode->value(), "pin_mode", pin_mode_id, true);
+        if (pin_mode_id.size()) {
+
+          if (where.size()) {
+
+            where += " AND";
+          }
+          where += " pin_mode.id=?";
+          cv.push_back (pin_mode_id);
+        }
+      }
+
+      printRecord (what, from, where, cv, orderby);
+      return; // << --------------------------- return
+    } //-- < pin
+
+    // list gpio [name_like/id]
+    // list gpio pin [gpio_name_like/gpio_id]  [-Mpin_mode]
+    else if (from == "gpio") {
+
+      if (args.size() > 2) { // gpio +
+
+        if (args[2] == "pin") {
+          vector<string> cv;
+
+          from.assign ("gpio_has_pin "
+                       "INNER JOIN gpio on gpio.id = gpio_has_pin.gpio_id "
+                       "INNER JOIN pin on pin.id = gpio_has_pin.pin_id "
+                       "INNER JOIN pin_type on pin_type.id = pin.pin_type_id "
+                       "INNER JOIN pin_has_name on pin.id = pin_has_name.pin_id "
+                       "INNER JOIN pin_name on pin_name.id = pin_has_name.pin_name_id "
+                       "INNER JOIN pin_mode on pin_mode.id = pin_has_name.pin_mode_id "
+                       "INNER JOIN pin_number on pin.id = pin_number.pin_id "
+                      );
+
+          what = WhatMap.at ("pin_gpio");
+
+          setWhereCondition (3, where, condition, like);
+          if (where.size() && condition.size()) {
+            if (where == "name") {
+              where = "gpio.name";
+            }
+            else if (where == "id") {
+              where = "gpio_has_pin.gpio_id";
+            }
+            where += (like ? " LIKE ?" : "=?");
+            cv.push_back (condition);
+          }
+
+          orderby = "ino_pin_num";
+          if (opPinMode->is_set()) {
+            string pin_mode_id;
+
+            readArg (opPinMode->value(), "pin_mode", pin_mode_id, true);
+            if (pin_mode_id.size()) {
+
+              if (where.size()) {
+
+                where += " AND";
+              }
+              where += " pin_mode.id=?";
+              cv.push_back (pin_mode_id);
+            }
+          }
+
+          printRecord (what, from, where, cv, orderby);
+          return; // << --------------------------- return
+        }
+
+      }
+
+      setWhereCondition (pos, where, condition, like);
+      what = WhatMap.at (from);
+    }
+    // list arch [name_like/id]
+    // list soc [name_like/id]
+    // list soc_family [name_like/id]
+    // list manufacturer [name_like/id]
+    // list board_family [name_like/id]
+    // list board_model [name_like/id]
+    // list connector_family [name_like/id]
+    // list pin_type [name_like/id]
+    // list pin_mode [name_like/id]
+    // list pin_name [name_like/id]
+    // list pin_number
+    else if (WhatMap.count (from))  {
+
+      setWhereCondition (pos, where, condition, like);
+      what = WhatMap.at (from);
+    }
+    else {
+
+      throw std::invalid_argument ("invalid table " + from);
+    }
+
+    printRecordEqual (what, from, where, condition, like, orderby);
+  }
+  else {
+
+    throw std::invalid_argument ("no table provided");
+  }
+}
+
+// -----------------------------------------------------------------------------
+void Pidbm::Private::selectRecordEqual (cppdb::result & res,
+                                        const std::vector<std::string> & what,
+                                        const std::string & from,
+                                        const std::string & where,
+                                        const std::string & condition,
+                                        bool like,
+                                        const std::string & orderby,
+                                        const std::string & groupby,
+                                        long long limit) {
+  std::ostringstream req;
+  std::vector<std::string> v;
+
+  if (where.size() && condition.size()) {
+    req << where << (like ? " LIKE " : "=") << "?";
+    v.push_back (condition);
+  }
+  selectRecord (res, what, from, req.str(), v, orderby, groupby, limit);
+}
+
+// -----------------------------------------------------------------------------
+void Pidbm::Private::deleteRecord (const std::vector<std::string> & what,
+                                   const std::string & from,
+                                   const std::string & where,
+                                   const std::string & condition,
+                                   bool like) {
+  string response;
+
+  if (opQuiet) {
+
+    response = "Y";
+  }
+  else {
+
+    long long n = printRecordEqual (what, from, where, condition, like);
+    cout << "Could you confirm the deletion of the " << n << "records above [y/N] ?  ";
+    cin >> response;
+  }
+
+  if (response == "y" || response == "Y") {
+    cppdb::statement stat;
+    std::ostringstream req;
+
+    string w = where + (like ? " LIKE " : "=") + "?";
+
+    req << "DELETE FROM " << from << " WHERE " << w;
+
+    // cout << req.str() << endl; // debug
+    journalKeys (from, 'D', w, vector<string> { condition });
+    stat = db << req.str() << condition;
+    stat.exec();
+  }
+}
+
+// -----------------------------------------------------------------------------
+void Pidbm::Private::updateRecord (const std::vector<std::string> & what,
+                                   const std::string & to,
+                                   const std::string & where,
+                                   const std::vector<std::string> & condition,
+                                   const std::vector<std::string> & values) {
+
+  std::ostringstream req;
+  cppdb::statement st;
+
+  req << "UPDATE " << to << " SET ";
+
+  for (size_t i = 0; i < what.size(); i++) {
+
+    size_t pos = what[i].rfind ('.');
+    if (pos == string::npos) {
+
+      req << what[i];
+    }
+    else {
+      req << what[i].substr (pos + 1);
+    }
+    req << "=?";
+    if (i < (what.size() - 1)) {
+      req << ',';
+    }
+  }
+  req << " WHERE " << where;
+  //cout << req.str() << endl; // debug
+
+  journalKeys (to, 'U', where, condition);
+  st = db << req.str();
+  for (auto v : values) {
+    st << v;
+  }
+  for (auto c : condition) {
+    st << c;
+  }
+
+  st.exec();
+  if (!opQuiet) {
+
+    cout << st.affected() << " record updated to " << to << "." << endl;
+  }
+}
+
+// -----------------------------------------------------------------------------
+long long Pidbm::Private::printRecordEqual (const std::vector<std::string> & what,
+    const std::string & from,
+    const std::string & where,
+    const std::string & condition,
+    bool like,
+    const std::string & orderby,
+    const std::string & groupby) {
+  std::ostringstream req;
+  std::vector<std::string> v;
+
+  if (where.size() && condition.size()) {
+    req << where << (like ? " LIKE " : "=") << "?";
+    v.push_back (condition);
+  }
+  return printRecord (what, from, req.str(), v, orderby, groupby);
+}
+
+// -----------------------------------------------------------------------------
+long long Pidbm::Private::printRecord (const std::vector<std::string> & what,
+                                       const std::string & from,
+                                       const std::string & where,
+                                       const std::vector<std::string> & condition,
+                                       const std::string & orderby,
+                                       const std::string & groupby) {
+  cppdb::result records;
+  vector<vector<string>> rows;
+  vector<int> colen;
+
+  // the rows are buffered to know the width of the columns
+  selectRecord (records, what, from, where, condition, orderby, groupby);
+  colen.assign (records.cols(), 0);
+  while (records.next()) {
+    vector<string> row (records.cols());
+
+    for (int i = 0; i < records.cols(); i++) {
+
+      records.fetch (i, row[i]);
+      colen[i] = std::max (colen[i], static_cast<int> (row[i].size()));
+    }
+    rows.push_back (row);
+  }
+
+  if (rows.size() > 0) {
+
+    printTableHeader (records, colen, what); // call that can modify colen
+    for (auto & row : rows) {
+
+      for (size_t i = 0; i < row.size(); i++) {
+        size_t padding = colen[i] - row[i].size() + 1;
+        cout << "| " << row[i] << string (padding, ' ');
+      }
+      cout << "|" << endl;
+    }
+    printTableLine (colen);
+    cout << rows.size() << " records found." << endl;
+  }
+  else {
+
+    cout << "No record found." << endl;
+  }
+  return rows.size();
+}
+
+// -----------------------------------------------------------------------------
+void Pidbm::Private::printTableHeader (cppdb::result & res, std::vector<int> & colen,
+                                       const std::vector<std::string> & what) {
+  vector<string> colname;
+
+  for (int i = 0; i < res.cols(); i++) {
+    size_t count = 0;
+
+    colname.push_back (columnNameCleanup (res.name (i)));
+
+    for (auto w : what) {
+      size_t pos = w.rfind (colname[i]);
+
+      if (pos != string::npos) {
+
+        if (pos > 0) {
+          if (w[pos - 1] == '.') {
+            count++;
+          }
+        }
+        else {
+          count ++;
+        }
+      }
+    }
+    if (count > 1) {
+
+      colname[i] = what[i];
+    }
+
+    if (colname[i].size() > static_cast<size_t> (colen[i])) {
+      colen[i] = colname[i].size();
+    }
+  }
+  printTableLine (colen);
+
+  for (int i = 0; i < res.cols(); i++) {
+
+    colname[i].resize (colen[i], ' ');
+    cout << "| " << colname[i] << ' ';
+  }
+  cout << "|" << endl;
+  printTableLine (colen);
+}
+
+// -----------------------------------------------------------------------------
+void Pidbm::Private::printTableLine (std::vector<int> & colen) {
+
+  for (size_t i = 0; i < colen.size(); i++) {
+    cout << '+' << string (colen[i] + 2, '-');
+  }
+  cout << '+' << endl;
+}
+
+// -----------------------------------------------------------------------------
+void Pidbm::Private::printTable (const std::vector<std::string> & header,
+                                 const std::vector<std::vector<std::string>> & rows) {
+  vector<int> colen;
+
+  for (auto & h : header) {
+    colen.push_back (h.size());
+  }
+  for (auto & r : rows) {
+    for (size_t i = 0; i < r.size() && i < colen.size(); i++) {
+      colen[i] = std::max (colen[i], static_cast<int> (r[i].size()));
+    }
+  }
+
+  printTableLine (colen);
+  for (size_t i = 0; i < header.size(); i++) {
+    cout << "| " << header[i] << string (colen[i] - header[i].size() + 1, ' ');
+  }
+  cout << "|" << endl;
+  printTableLine (colen);
+  for (auto & r : rows) {
+    for (size_t i = 0; i < r.size() && i < colen.size(); i++) {
+      cout << "| " << r[i] << string (colen[i] - r[i].size() + 1, ' ');
+    }
+    cout << "|" << endl;
+  }
+  printTableLine (colen);
+}
+
+// -----------------------------------------------------------------------------
+std::string Pidbm::Private::columnNameCleanup (const std::string & name) {
+  const string printHex ("printf(\"0x%x\",");
+  string str (name);
+
+  if (name.find (printHex) == 0) {
+
+    str.erase (0, printHex.size());
+    str.erase (str.rfind (")"), 1);
+  }
+  return str;
+}
+
+// -----------------------------------------------------------------------------
+void Pidbm::Private::setWhereCondition (const std::string & arg, std::string & where,
+                                        std::string & condition, bool & like) {
+  string add_to_where;
+  bool id = true;
+  unsigned long i;
+
+  try {
+    std::size_t p = 0;
+
+    i = std::stol (arg, &p, 0);
+    if (p != arg.size()) {
+      id = false;
+    }
+  }
+  catch (...) {
+
+    id = false;
+  }
+
+  if (id) {
+
+    add_to_where = "id";
+    condition = to_string (i);
+  }
+  else {
+
+    add_to_where = "name";
+    like = true;
+    condition = arg;
+  }
+  if (where.empty()) {
+
+    where = add_to_where;
+  }
+  else {
+    if (where.rfind ('.') == (where.size() - 1)) {
+
+      where = where + add_to_where;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void Pidbm::Private::setWhereCondition (size_t pos, std::string & where,
+                                        std::string & condition, bool & like) {
+  auto args =  op.non_option_args();
+
+  if (args.size() > pos) {
+
+    setWhereCondition (args[pos], where, condition, like);
+  }
+}
+
+// -----------------------------------------------------------------------------
+bool Pidbm::Private::readArg (size_t pos, const std::string & from,
+                              long long & id, bool caseInsensitive) {
+  cppdb::result res;
+  string where, condition;
+  bool like;
+  bool found = false;
+
+  setWhereCondition (pos + 2, where, condition, like);
+  if (caseInsensitive && where == "name") {
+    condition = toLower (condition);
+    where = "lower(name)";
+  }
+  selectRecordEqual (res, {"id"}, from, where, condition, false, "", "", 1);
+
+  if (res.next()) {
+    res >> id;
+    found = true;
+  }
+  return found;
+}
+
+// -----------------------------------------------------------------------------
+bool Pidbm::Private::readArg (size_t pos, const std::string & from,
+                              std::string & id, bool caseInsensitive) {
+  long long i;
+
+  bool found = readArg (pos, from, i, caseInsensitive);
+  if (found) {
+
+    id = to_string (i);
+  }
+  return found;
+}
+
+// -----------------------------------------------------------------------------
+bool Pidbm::Private::readArg (const std::string & arg, const std::string & from,
+                              long long & id, bool caseInsensitive) {
+  cppdb::result res;
+  string where, condition;
+  bool like;
+  bool found = false;
+
+  setWhereCondition (arg, where, condition, like);
+  if (caseInsensitive && where == "name") {
+    condition = toLower (condition);
+    where = "lower(name)";
+  }
+  selectRecordEqual (res, {"id"}, from, where, condition, false, "", "", 1);
+
+  if (res.next()) {
+    res >> id;
+    found = true;
+  }
+  return found;
+}
+
+// -----------------------------------------------------------------------------
+bool Pidbm::Private::readArg (const std::string & arg, const std::string & from,
+                              std::string & id, bool caseInsensitive) {
+  long long i;
 
-          what = WhatMap.at ("pin_gpio");
+  bool found = readArg (arg, from, i, caseInsensitive);
+  if (found) {
 
-          setWhereCondition (3, where, condition, like);
-          if (where.size() && condition.size()) {
-            if (where == "name") {
-              where = "gpio.name";
-            }
-            else if (where == "id") {
-              where = "gpio_has_pin.gpio_id";
-            }
-            where += (like ? " LIKE ?" : "=?");
-            cv.push_back (condition);
-          }
+    id = to_string (i);
+  }
+  return found;
+}
 
-          orderby = "ino_pin_num";
-          if (opPinMode->is_set()) {
-            string pin_mode_id;
+// -----------------------------------------------------------------------------
+long long Pidbm::Private::nameExists (const std::string & from,
+                                      const std::string & name, bool caseInsensitive) {
+  long long name_id = -1;
+  cppdb::result records;
+  string where = caseInsensitive ? "lower(name)" : "name";
+  string condition = caseInsensitive ? toLower (name) : name;
 
-            readArg (opPinMode->value(), "pin_mode", pin_mode_id, true);
-            if (pin_mode_id.size()) {
+  selectRecordEqual (records, {"id"}, from, where, condition, false, "", "", 1);
+  if (records.next()) {
 
-              if (where.size()) {
+    records >> name_id;
+  }
+  return name_id;
+}
 
-                where += " AND";
-              }
-              where += " pin_mode.id=?";
-              cv.push_back (pin_mode_id);
-            }
-          }
+// -----------------------------------------------------------------------------
+bool Pidbm::Private::idExists (const std::string & from, const std::string & id) {
+  cppdb::result records;
 
-          printRecord (what, from, where, cv, orderby);
-          return; // << --------------------------- return
-        }
+  selectRecordEqual (records, {"id"}, from, "id", id, false, "", "", 1);
+  return records.next();
+}
 
-      }
+// -----------------------------------------------------------------------------
+bool Pidbm::Private::idExists (const std::string & from, const long long & id) {
 
-      setWhereCondition (pos, where, condition, like);
-      what = WhatMap.at (from);
-    }
-    // list arch [name_like/id]
-    // list soc [name_like/id]
-    // list soc_family [name_like/id]
-    // list manufacturer [name_like/id]
-    // list board_family [name_like/id]
-    // list board_model [name_like/id]
-    // list connector_family [name_like/id]
-    // list pin_type [name_like/id]
-    // list pin_mode [name_like/id]
-    // list pin_name [name_like/id]
-    // list pin_number
-    else if (WhatMap.count (from))  {
+  return idExists (from, to_string (id));
+}
 
-      setWhereCondition (pos, where, condition, like);
-      what = WhatMap.at (from);
-    }
-    else {
+// -----------------------------------------------------------------------------
+bool Pidbm::Private::indexExists (const std::string & name) {
+  cppdb::result res;
+  int n;
 
-      throw std::invalid_argument ("invalid table " + from);
-    }
+  if (db.engine() == "postgresql") {
 
-    printRecordEqual (what, from, where, condition, like, orderby);
+    res = db << "SELECT COUNT(*) FROM pg_indexes "
+          "WHERE schemaname=current_schema() AND indexname=?" << name << cppdb::row;
+  }
+  else if (db.engine() == "mysql") {
+
+    res = db << "SELECT COUNT(*) FROM information_schema.statistics "
+          "WHERE table_schema=DATABASE() AND index_name=?" << name << cppdb::row;
   }
   else {
 
-    throw std::invalid_argument ("no table provided");
+    res = db << "SELECT COUNT(*) FROM sqlite_master "
+          "WHERE type='index' AND name=?" << name << cppdb::row;
   }
+  res >> n;
+  return n > 0;
 }
 
 // -----------------------------------------------------------------------------
-long long Pidbm::Private::selectRecordEqual (cppdb::result & res,
-    const std::vector<std::string> & what,
-    const std::string & from,
-    const std::string & where,
-    const std::string & condition,
-    bool like,
-    const std::string & orderby,
-    const std::string & groupby) {
-  std::ostringstream req;
-  std::vector<std::string> v;
+bool Pidbm::Private::hasUniqueKey (const std::string & table,
+                                   const std::vector<std::string> & columns) {
+  vector<string> c (columns);
+  const Table * t = findTable (table);
+
+  std::sort (c.begin(), c.end());
+  if (t) {
+    vector<string> k (t->key);
+
+    std::sort (k.begin(), k.end());
+    if (k == c) {
+      return true;
+    }
+  }
 
-  if (where.size() && condition.size()) {
-    req << where << (like ? " LIKE " : "=") << "?";
-    v.push_back (condition);
+  for (auto & u : UniqueKeys) {
+    vector<string> k (u.key);
+
+    std::sort (k.begin(), k.end());
+    if (u.name == table && k == c) {
+      auto it = uniqueKeyCache.find (table);
+
+      if (it == uniqueKeyCache.end()) {
+
+        it = uniqueKeyCache.emplace (table, indexExists (table + "_uniq")).first;
+      }
+      return it->second;
+    }
   }
-  return selectRecord (res, what, from, req.str(), v, orderby, groupby);
+  return false;
 }
 
 // -----------------------------------------------------------------------------
-void Pidbm::Private::deleteRecord (const std::vector<std::string> & what,
-                                   const std::string & from,
-                                   const std::string & where,
-                                   const std::string & condition,
-                                   bool like) {
-  string response;
+std::string Pidbm::Private::insertHead (bool upsert) {
 
-  if (opQuiet) {
+  if (upsert && db.engine() == "mysql") {
 
-    response = "Y";
+    return "INSERT IGNORE INTO ";
   }
-  else {
+  if (upsert && db.engine() == "sqlite3" && sqliteVersion() < 3024000) {
 
-    long long n = printRecordEqual (what, from, where, condition, like);
-    cout << "Could you confirm the deletion of the " << n << "records above [y/N] ?  ";
-    cin >> response;
+    return "INSERT OR IGNORE INTO ";
   }
+  return "INSERT INTO ";
+}
 
-  if (response == "y" || response == "Y") {
-    cppdb::statement stat;
-    std::ostringstream req;
+// -----------------------------------------------------------------------------
+std::string Pidbm::Private::insertTail (bool upsert, const std::string & columns) {
 
-    req << "DELETE FROM " << from << " WHERE " << where << (like ? " LIKE " : "=") << "?";
+  if (upsert && db.engine() != "mysql" &&
+      ! (db.engine() == "sqlite3" && sqliteVersion() < 3024000)) {
 
-    // cout << req.str() << endl; // debug
-    stat = db << req.str() << condition;
-    stat.exec();
+    // the conflict target restricts the no-op to this key, the other
+    // constraints, the primary key for example, still fail
+    return " ON CONFLICT (" + columns + ") DO NOTHING";
   }
+  return std::string();
 }
 
 // -----------------------------------------------------------------------------
-void Pidbm::Private::updateRecord (const std::vector<std::string> & what,
-                                   const std::string & to,
-                                   const std::string & where,
-                                   const std::vector<std::string> & condition,
-                                   const std::vector<std::string> & values) {
-
-  std::ostringstream req;
-  cppdb::statement st;
+int Pidbm::Private::sqliteVersion() {
 
-  req << "UPDATE " << to << " SET ";
+  if (sqliteVersionNumber == 0) {
+    cppdb::result res = db << "SELECT sqlite_version()" << cppdb::row;
+    string v;
+    int major = 0, minor = 0, patch = 0;
 
-  for (size_t i = 0; i < what.size(); i++) {
+    res >> v;
+    std::sscanf (v.c_str(), "%d.%d.%d", &major, &minor, &patch);
+    sqliteVersionNumber = major * 1000000 + minor * 1000 + patch;
+  }
+  return sqliteVersionNumber;
+}
 
-    size_t pos = what[i].rfind ('.');
-    if (pos == string::npos) {
+// -----------------------------------------------------------------------------
+// Default limits of the backends, SQLITE_MAX_VARIABLE_NUMBER is 999 before
+// SQLite 3.32, PostgreSQL and MySQL use a 16-bit count.
+size_t Pidbm::Private::bindParameterLimit() {
 
-      req << what[i];
-    }
-    else {
-      req << what[i].substr (pos + 1);
-    }
-    req << "=?";
-    if (i < (what.size() - 1)) {
-      req << ',';
-    }
-  }
-  req << " WHERE " << where;
-  //cout << req.str() << endl; // debug
+  if (db.engine() == "postgresql" || db.engine() == "mysql") {
 
-  st = db << req.str();
-  for (auto v : values) {
-    st << v;
-  }
-  for (auto c : condition) {
-    st << c;
+    return 65535;
   }
+  if (db.engine() == "sqlite3" && sqliteVersion() >= 3032000) {
 
-  st.exec();
-  if (!opQuiet) {
-
-    cout << st.affected() << " record updated to " << to << "." << endl;
+    return 32766;
   }
+  return MaxBindParameters;
 }
 
 // -----------------------------------------------------------------------------
-long long Pidbm::Private::printRecordEqual (const std::vector<std::string> & what,
-    const std::string & from,
-    const std::string & where,
-    const std::string & condition,
-    bool like,
-    const std::string & orderby,
-    const std::string & groupby) {
-  std::ostringstream req;
-  std::vector<std::string> v;
+// Resolves a list of pin selectors with a single query, for each selector,
+// pins[i] contains the id of the matching pins, empty if nothing found.
+// A selector is a pin id, an id range (98-160), a name or a name glob (PA*),
+// names are those of the input mode, case insensitive.
+// Returns the number of selectors resolved.
+size_t Pidbm::Private::resolvePins (const std::vector<std::string> & selectors,
+                                    std::vector<std::vector<long long>> & pins) {
+  enum { Id, Range, Name, Glob };
+  vector<int> kind;
+  vector<pair<long long, long long>> bounds;
+  vector<string> keys; // lower-case names/globs
+  size_t resolved = 0;
+
+  pins.assign (selectors.size(), vector<long long>());
+
+  for (auto & sel : selectors) {
+    size_t dash = sel.find ('-');
+    auto isNumber = [] (const string & str) {
+      return str.size() && str.find_first_not_of ("0123456789") == string::npos;
+    };
+
+    keys.push_back (toLower (sel));
+    bounds.push_back ({ -1, -1});
+    if (isNumber (sel)) {
+
+      kind.push_back (Id);
+      bounds.back().first = bounds.back().second = stoll (sel);
+    }
+    else if (dash != string::npos && isNumber (sel.substr (0, dash)) &&
+             isNumber (sel.substr (dash + 1))) {
 
-  if (where.size() && condition.size()) {
-    req << where << (like ? " LIKE " : "=") << "?";
-    v.push_back (condition);
-  }
-  return printRecord (what, from, req.str(), v, orderby, groupby);
-}
+      kind.push_back (Range);
+      bounds.back().first = stoll (sel.substr (0, dash));
+      bounds.back().second = stoll (sel.substr (dash + 1));
+    }
+    else if (sel.find_first_of ("*?") != string::npos) {
 
-// -----------------------------------------------------------------------------
-long long Pidbm::Private::printRecord (const std::vector<std::string> & what,
-                                       const std::string & from,
-                                       const std::string & where,
-                                       const std::vector<std::string> & condition,
-                                       const std::string & orderby,
-                                       const std::string & groupby) {
-  long long n;
-  cppdb::result records;
+      kind.push_back (Glob);
+    }
+    else {
 
-  n = selectRecord (records, what, from, where, condition, orderby, groupby);
+      kind.push_back (Name);
+    }
+  }
 
-  if (n > 0) {
-    int len;
+  // one query per chunk of selectors
+  const size_t chunk = bindParameterLimit() / 2;
+  for (size_t first = 0; first < selectors.size(); first += chunk) {
+    size_t last = std::min (selectors.size(), first + chunk);
     std::ostringstream req;
-    cppdb::result res;
-    vector<int> colen;
+    vector<string> ids, names;
     cppdb::statement st;
+    cppdb::result res;
 
-    // query to calculate the width of the columns
-    req << "SELECT ";
-    for (size_t i = 0; i < what.size(); i++) {
-      string str (what[i]);
+    req << "SELECT pin_has_name.pin_id,pin_name.name "
+        "FROM pin_has_name "
+        "INNER JOIN pin_name ON pin_has_name.pin_name_id = pin_name.id "
+        "WHERE pin_has_name.pin_mode_id=0 AND (";
+
+    for (size_t i = first; i < last; i++) {
 
-      if (str[0] == '%') {
-        str.erase (0, 1);
+      if (kind[i] == Id) {
+        ids.push_back (keys[i]);
       }
-      req << "MAX(LENGTH(" << str << "))";
-      if (i < (what.size() - 1)) {
-        req << ',';
+      else if (kind[i] == Name) {
+        names.push_back (keys[i]);
       }
     }
 
-    req << " FROM " << from;
+    string sep;
+    if (ids.size()) {
 
-    if (where.size() && condition.size()) {
-      req << " WHERE " << where;
-      st = db << req.str();
-      for (auto c : condition) {
-        st << c;
+      req << "pin_has_name.pin_id IN (";
+      for (size_t i = 0; i < ids.size(); i++) {
+        req << (i ? ",?" : "?");
       }
+      req << ')';
+      sep = " OR ";
     }
-    else {
-      st = db << req.str();
+    if (names.size()) {
+
+      req << sep << "lower(pin_name.name) IN (";
+      for (size_t i = 0; i < names.size(); i++) {
+        req << (i ? ",?" : "?");
+      }
+      req << ')';
+      sep = " OR ";
+    }
+    for (size_t i = first; i < last; i++) {
+
+      if (kind[i] == Range) {
+
+        req << sep << "pin_has_name.pin_id BETWEEN ? AND ?";
+        sep = " OR ";
+      }
+      else if (kind[i] == Glob) {
+
+        req << sep << "lower(pin_name.name) LIKE ?";
+        sep = " OR ";
+      }
     }
+    req << ") ORDER BY pin_has_name.pin_id";
     //cout << req.str() << endl; // debug
-    res = st.row();
 
-    for (int i = 0; i < res.cols(); i++) {
+    st = db << req.str();
+    for (auto & id : ids) {
+      st << id;
+    }
+    for (auto & name : names) {
+      st << name;
+    }
+    for (size_t i = first; i < last; i++) {
+
+      if (kind[i] == Range) {
+
+        st << bounds[i].first << bounds[i].second;
+      }
+      else if (kind[i] == Glob) {
+        string like (keys[i]);
 
-      res.fetch (i, len);
-      colen.push_back (len);
+        std::replace (like.begin(), like.end(), '*', '%');
+        std::replace (like.begin(), like.end(), '?', '_');
+        st << like;
+      }
     }
 
-    printTable (records, colen, what);
-    cout << n << " records found." << endl;
+    res = st.query();
+    while (res.next()) {
+      long long id;
+      string name;
+
+      res >> id >> name;
+      name = toLower (name);
+      for (size_t i = first; i < last; i++) {
+        bool match;
+
+        switch (kind[i]) {
+          case Name:
+            match = (keys[i] == name);
+            break;
+          case Glob:
+            match = (fnmatch (keys[i].c_str(), name.c_str(), 0) == 0);
+            break;
+          default:
+            match = (id >= bounds[i].first && id <= bounds[i].second);
+            break;
+        }
+        if (match) {
+
+          pins[i].push_back (id);
+        }
+      }
+    }
   }
-  else {
 
-    cout << "No record found." << endl;
+  for (auto & p : pins) {
+    if (p.size()) {
+      resolved++;
+    }
   }
-  return n;
+  return resolved;
 }
 
 // -----------------------------------------------------------------------------
-void Pidbm::Private::printTable (cppdb::result & res, std::vector<int> & colen,
-                                 const std::vector<std::string> & what) {
+// Reads the lines of the file provided with --from-file (- for stdin),
+// stdin is used if no file provided. Empty lines and comments (#) are skipped.
+std::vector<std::string> Pidbm::Private::readInputLines() {
+  vector<string> lines;
+  std::ifstream file;
+  std::istream * is = &cin;
+  string line;
 
-  printTableHeader (res, colen, what); // call that can modify colen
-  while (res.next()) {
+  if (opFromFile->is_set() && opFromFile->value() != "-") {
 
-    for (int i = 0; i < res.cols(); i++) {
-      string value;
+    file.open (opFromFile->value());
+    if (!file) {
 
-      res.fetch (i, value);
-      size_t padding = colen[i] - value.size() + 1;
-      cout << "| " << value << string (padding, ' ');
+      throw std::invalid_argument ("unable to open " + opFromFile->value());
     }
-    cout << "|" << endl;
+    is = &file;
   }
-  printTableLine (colen);
+
+  while (getline (*is, line)) {
+    size_t pos = line.find ('#');
+
+    if (pos != string::npos) {
+      line.erase (pos);
+    }
+    if (line.find_first_not_of (" \t\r,") != string::npos) {
+      lines.push_back (line);
+    }
+  }
+  return lines;
 }
 
 // -----------------------------------------------------------------------------
-void Pidbm::Private::printTableHeader (cppdb::result & res, std::vector<int> & colen,
-                                       const std::vector<std::string> & what) {
-  vector<string> colname;
+// Copies a gpio with its pins and its connectors, returns the id of the copy.
+// A connector is inserted per connector, the records of connector_has_pin,
+// gpio_has_connector and gpio_has_pin with one INSERT ... SELECT per table,
+// the ids of the connectors are mapped to those of their copies with a CASE.
+// A connector named after the gpio, nanopineo-cn1 for nanopineo, is renamed
+// after the copy, the others are prefixed by its name.
+long long Pidbm::Private::copyGpio (long long src, const std::string & name) {
+  cppdb::result res;
+  cppdb::statement st;
+  string srcName, cases, list;
+  vector<std::pair<long long, string>> connectors;
+  vector<string> keys;
+  long long id;
 
-  for (int i = 0; i < res.cols(); i++) {
-    size_t count = 0;
+  res = db << "SELECT name FROM gpio WHERE id=?" << src << cppdb::row;
+  res >> srcName;
 
-    colname.push_back (columnNameCleanup (res.name (i)));
+  st = db << "INSERT INTO gpio(name,board_family_id) "
+       "SELECT ?,board_family_id FROM gpio WHERE id=?" << name << src;
+  st.exec();
+  id = st.last_insert_id();
+  journal ("gpio", 'I', "id=" + to_string (id));
 
-    for (auto w : what) {
-      size_t pos = w.rfind (colname[i]);
+  res = db << "SELECT DISTINCT connector.id,connector.name FROM connector "
+        "INNER JOIN gpio_has_connector ON connector.id=gpio_has_connector.connector_id "
+        "WHERE gpio_id=?" << src;
+  while (res.next()) {
+    long long c;
+    string n;
 
-      if (pos != string::npos) {
+    res >> c >> n;
+    connectors.push_back ({ c, n });
+  }
 
-        if (pos > 0) {
-          if (w[pos - 1] == '.') {
-            count++;
-          }
-        }
-        else {
-          count ++;
+  for (auto & c : connectors) {
+    string n = c.second.compare (0, srcName.size(), srcName) == 0 ?
+               name + c.second.substr (srcName.size()) : name + "-" + c.second;
+    long long nc;
+
+    st = db << "INSERT INTO connector(name,rows,connector_family_id) "
+         "SELECT ?,rows,connector_family_id FROM connector WHERE id=?" << n << c.first;
+    st.exec();
+    nc = st.last_insert_id();
+    keys.push_back ("id=" + to_string (nc));
+    cases += " WHEN " + to_string (c.first) + " THEN " + to_string (nc);
+    list += (list.empty() ? "" : ",") + to_string (c.first);
+  }
+  journal ("connector", 'I', keys);
+
+  if (connectors.size()) {
+
+    db << "INSERT INTO connector_has_pin(connector_id,pin_id,row,column) "
+       "SELECT CASE connector_id" + cases + " END,pin_id,row,column "
+       "FROM connector_has_pin WHERE connector_id IN (" + list + ")" << cppdb::exec;
+    st = db << "INSERT INTO gpio_has_connector(gpio_id,num,connector_id) "
+         "SELECT ?,num,CASE connector_id" + cases + " END "
+         "FROM gpio_has_connector WHERE gpio_id=?" << id << src;
+    st.exec();
+  }
+  st = db << "INSERT INTO gpio_has_pin(gpio_id,pin_id,ino_pin_num) "
+       "SELECT ?,pin_id,ino_pin_num FROM gpio_has_pin WHERE gpio_id=?" << id << src;
+  st.exec();
+
+  journalKeys ("connector_has_pin", 'I',
+               "connector_id IN (SELECT connector_id FROM gpio_has_connector WHERE gpio_id=?)",
+               vector<long long> { id });
+  journalKeys ("gpio_has_connector", 'I', "gpio_id=?", vector<long long> { id });
+  journalKeys ("gpio_has_pin", 'I', "gpio_id=?", vector<long long> { id });
+  return id;
+}
+
+// -----------------------------------------------------------------------------
+// Prints the GPIO pins of a SoC, a row per pin and a column per mode, from a
+// single query ordered by SoC pin number. A table is printed per port, PA, PB...
+// as soon as it is complete, with the modes used by the port. Returns the
+// number of pins.
+long long Pidbm::Private::printPinModeMatrix (long long soc_id, const std::string & soc_name) {
+  const long long input = 0; // id of the input mode, its name labels the pin
+  cppdb::result res;
+  std::map<long long, string> modes; // of the port
+  vector<std::pair<long long, std::map<long long, string>>> pins; // of the port
+  string port;
+  long long n = 0, last = -1;
+
+  auto print = [&] () {
+    vector<string> header = { "pin", "id" };
+    vector<vector<string>> rows;
+
+    if (pins.empty()) {
+      return;
+    }
+    for (auto & m : modes) {
+      if (m.first != input) {
+        header.push_back (m.second);
+      }
+    }
+    for (auto & p : pins) {
+      vector<string> row = { p.second[input], to_string (p.first) };
+
+      for (auto & m : modes) {
+        if (m.first != input) {
+          row.push_back (p.second.count (m.first) ? p.second[m.first] : "");
         }
       }
+      rows.push_back (row);
     }
-    if (count > 1) {
+    cout << soc_name << " " << port << endl;
+    printTable (header, rows);
+    cout << endl;
+    n += pins.size();
+    modes.clear();
+    pins.clear();
+  };
+
+  res = db << "SELECT pin.id,pin_mode.id,pin_mode.name,pin_name.name "
+        "FROM soc_has_pin "
+        "INNER JOIN pin ON pin.id=soc_has_pin.pin_id "
+        "INNER JOIN pin_has_name ON pin_has_name.pin_id=pin.id "
+        "INNER JOIN pin_name ON pin_name.id=pin_has_name.pin_name_id "
+        "INNER JOIN pin_mode ON pin_mode.id=pin_has_name.pin_mode_id "
+        "LEFT JOIN pin_number ON pin_number.pin_id=pin.id "
+        "WHERE soc_has_pin.soc_id=? AND pin.pin_type_id=? "
+        "ORDER BY pin_number.soc_pin_num,pin.id,pin_mode.id"
+        << soc_id << static_cast<int> (Pin::Type::Gpio);
+  while (res.next()) {
+    long long pin, mode;
+    string modeName, name;
 
-      colname[i] = what[i];
+    res >> pin >> mode >> modeName >> name;
+    if (pin != last) {
+
+      pins.push_back ({ pin, {} });
+      last = pin;
     }
+    if (mode == input) {
+      // the port is the input name without its number, PA for PA12
+      string p = name.substr (0, name.find_last_not_of ("0123456789") + 1);
 
-    if (colname[i].size() > static_cast<size_t> (colen[i])) {
-      colen[i] = colname[i].size();
+      if (p != port) {
+        auto current = pins.back();
+
+        pins.pop_back();
+        print();
+        pins.push_back (current);
+        port = p;
+      }
     }
+    modes[mode] = modeName;
+    pins.back().second[mode] = name;
   }
-  printTableLine (colen);
+  print();
 
-  for (int i = 0; i < res.cols(); i++) {
+  if (!opQuiet) {
 
-    colname[i].resize (colen[i], ' ');
-    cout << "| " << colname[i] << ' ';
+    cout << n << " pins found." << endl;
   }
-  cout << "|" << endl;
-  printTableLine (colen);
+  return n;
 }
 
 // -----------------------------------------------------------------------------
-void Pidbm::Private::printTableLine (std::vector<int> & colen) {
+const Pidbm::Private::Table * Pidbm::Private::findTable (const std::string & name) {
 
-  for (size_t i = 0; i < colen.size(); i++) {
-    cout << '+' << string (colen[i] + 2, '-');
+  for (auto & t : Tables) {
+    if (t.name == name) {
+      return &t;
+    }
   }
-  cout << '+' << endl;
+  return nullptr;
 }
 
 // -----------------------------------------------------------------------------
-std::string Pidbm::Private::columnNameCleanup (const std::string & name) {
-  const string printHex ("printf(\"0x%x\",");
-  string str (name);
+// The journal is created on the first write, the DDL depends on the backend
+void Pidbm::Private::createJournal (cppdb::session & s) {
+  string seq;
 
-  if (name.find (printHex) == 0) {
+  if (s.engine() == "mysql") {
 
-    str.erase (0, printHex.size());
-    str.erase (str.rfind (")"), 1);
+    seq = "seq BIGINT NOT NULL AUTO_INCREMENT PRIMARY KEY";
   }
-  return str;
+  else if (s.engine() == "postgresql") {
+
+    seq = "seq BIGSERIAL PRIMARY KEY";
+  }
+  else {
+
+    seq = "seq INTEGER PRIMARY KEY AUTOINCREMENT";
+  }
+  s << "CREATE TABLE IF NOT EXISTS pidbm_journal ("
+    + seq + ","
+    "stamp BIGINT NOT NULL,"
+    "table_name VARCHAR(64) NOT NULL,"
+    "row_key VARCHAR(255) NOT NULL,"
+    "operation CHAR(1) NOT NULL)" << cppdb::exec;
 }
 
 // -----------------------------------------------------------------------------
-void Pidbm::Private::setWhereCondition (const std::string & arg, std::string & where,
-                                        std::string & condition, bool & like) {
-  string add_to_where;
-  bool id = true;
-  unsigned long i;
+// Serialises the transactions that write the journal until their end, so
+// that the sequence numbers are committed in order and log --since does not
+// miss an entry committed late with a lower number. SQLite serialises the
+// writers by itself, the lock of MySQL is released by unlockJournal().
+void Pidbm::Private::lockJournal (cppdb::session & s) {
 
-  try {
-    std::size_t p = 0;
+  if (s.engine() == "postgresql") {
 
-    i = std::stol (arg, &p, 0);
-    if (p != arg.size()) {
-      id = false;
-    }
+    // does not block the readers, released at the end of the transaction
+    s << "LOCK TABLE pidbm_journal IN SHARE ROW EXCLUSIVE MODE" << cppdb::exec;
   }
-  catch (...) {
+  else if (s.engine() == "mysql") {
 
-    id = false;
+    s << "SELECT GET_LOCK('pidbm_journal',-1)" << cppdb::row;
   }
+}
 
-  if (id) {
+// -----------------------------------------------------------------------------
+// Releases the lock of lockJournal() after the commit or the rollback
+void Pidbm::Private::unlockJournal (cppdb::session & s) {
 
-    add_to_where = "id";
-    condition = to_string (i);
-  }
-  else {
+  if (s.engine() == "mysql") {
 
-    add_to_where = "name";
-    like = true;
-    condition = arg;
+    s << "SELECT RELEASE_LOCK('pidbm_journal')" << cppdb::row;
   }
-  if (where.empty()) {
+}
 
-    where = add_to_where;
-  }
-  else {
-    if (where.rfind ('.') == (where.size() - 1)) {
+// -----------------------------------------------------------------------------
+// Appends an entry per key to the journal, operation is 'I' (insertion),
+// 'U' (update) or 'D' (deletion). An empty key means that several records
+// of the table may have changed.
+void Pidbm::Private::journal (cppdb::session & s, const std::string & table,
+                              char operation, const std::vector<std::string> & keys) {
+  const size_t chunk = MaxBindParameters / 4;
+  long long stamp = time (nullptr);
+  string op (1, operation);
+
+  for (size_t first = 0; first < keys.size(); first += chunk) {
+    size_t last = std::min (keys.size(), first + chunk);
+    std::ostringstream req;
+    cppdb::statement st;
 
-      where = where + add_to_where;
+    req << "INSERT INTO pidbm_journal(stamp,table_name,row_key,operation) VALUES";
+    for (size_t i = first; i < last; i++) {
+      req << (i > first ? ",(?,?,?,?)" : "(?,?,?,?)");
     }
+    st = s << req.str();
+    for (size_t i = first; i < last; i++) {
+      st << stamp << table << keys[i] << op;
+    }
+    st.exec();
   }
 }
 
 // -----------------------------------------------------------------------------
-void Pidbm::Private::setWhereCondition (size_t pos, std::string & where,
-                                        std::string & condition, bool & like) {
-  auto args =  op.non_option_args();
-
-  if (args.size() > pos) {
+void Pidbm::Private::journal (const std::string & table, char operation,
+                              const std::vector<std::string> & keys) {
 
-    setWhereCondition (args[pos], where, condition, like);
-  }
+  openJournal();
+  journal (db, table, operation, keys);
 }
 
 // -----------------------------------------------------------------------------
-bool Pidbm::Private::readArg (size_t pos, const std::string & from,
-                              long long & id, bool caseInsensitive) {
-  cppdb::result res;
-  string where, condition;
-  bool like;
-  bool found = false;
+// Creates the journal at its first use and begins the write
+void Pidbm::Private::openJournal() {
 
-  setWhereCondition (pos + 2, where, condition, like);
-  if (caseInsensitive && where == "name") {
-    condition = toLower (condition);
-    where = "lower(name)";
+  if (!journalReady) {
+
+    if (db.engine() != "mysql") {
+
+      // rolled back with the command on dry run
+      beginWrite();
+      createJournal (db);
+    }
+    else if (transactionBegun) {
+
+      // the DDL would commit implicitly the current transaction
+      cppdb::session s (cinfo);
+      createJournal (s);
+    }
+    else {
+
+      createJournal (db);
+    }
+    journalReady = true;
   }
-  selectRecordEqual (res, {"id"}, from, where, condition);
+  beginWrite();
+  if (transactionBegun && !journalLocked) {
 
-  if (res.next()) {
-    res >> id;
-    found = true;
+    lockJournal (db);
+    journalLocked = true;
   }
-  return found;
 }
 
 // -----------------------------------------------------------------------------
-bool Pidbm::Private::readArg (size_t pos, const std::string & from,
-                              std::string & id, bool caseInsensitive) {
-  long long i;
+// Begins the transaction of the command, if any, before its first write
+void Pidbm::Private::beginWrite() {
 
-  bool found = readArg (pos, from, i, caseInsensitive);
-  if (found) {
+  if (transactionDepth > 0 && !transactionBegun && !opReadOnly) {
 
-    id = to_string (i);
+    db.begin();
+    transactionBegun = true;
   }
-  return found;
 }
 
 // -----------------------------------------------------------------------------
-bool Pidbm::Private::readArg (const std::string & arg, const std::string & from,
-                              long long & id, bool caseInsensitive) {
-  cppdb::result res;
-  string where, condition;
-  bool like;
-  bool found = false;
-
-  setWhereCondition (arg, where, condition, like);
-  if (caseInsensitive && where == "name") {
-    condition = toLower (condition);
-    where = "lower(name)";
-  }
-  selectRecordEqual (res, {"id"}, from, where, condition);
+void Pidbm::Private::journal (const std::string & table, char operation,
+                              const std::string & key) {
 
-  if (res.next()) {
-    res >> id;
-    found = true;
-  }
-  return found;
+  journal (table, operation, vector<string> { key });
 }
 
 // -----------------------------------------------------------------------------
-bool Pidbm::Private::readArg (const std::string & arg, const std::string & from,
-                              std::string & id, bool caseInsensitive) {
-  long long i;
+//
+//                     Pidbm::Private::Transaction Class
+//
+// -----------------------------------------------------------------------------
 
-  bool found = readArg (arg, from, i, caseInsensitive);
-  if (found) {
+// -----------------------------------------------------------------------------
+Pidbm::Private::Transaction::Transaction (Private * d) : _d (d), _committed (false) {
 
-    id = to_string (i);
+  if (_d->transactionDepth++ > 0) {
+
+    _d->beginWrite();
   }
-  return found;
 }
 
 // -----------------------------------------------------------------------------
-long long Pidbm::Private::nameExists (const std::string & from,
-                                      const std::string & name, bool caseInsensitive) {
-  long long name_id = -1;
-  cppdb::result records;
-  string where = caseInsensitive ? "lower(name)" : "name";
-  string condition = caseInsensitive ? toLower (name) : name;
+Pidbm::Private::Transaction::~Transaction() {
 
-  selectRecordEqual (records, {"id"}, from, where, condition);
-  if (records.next()) {
+  if (--_d->transactionDepth == 0 && _d->transactionBegun) {
 
-    records >> name_id;
+    _d->transactionBegun = false;
+    if (!_committed) {
+
+      try {
+        _d->db.rollback();
+        if (_d->journalLocked) {
+
+          _d->journalLocked = false;
+          unlockJournal (_d->db);
+        }
+      }
+      catch (...) {}
+    }
   }
-  return name_id;
 }
 
 // -----------------------------------------------------------------------------
-bool Pidbm::Private::idExists (const std::string & from, const std::string & id) {
-  cppdb::result records;
+void Pidbm::Private::Transaction::commit() {
 
-  selectRecordEqual (records, {"id"}, from, "id", id);
-  return records.next();
+  if (_d->transactionDepth == 1 && _d->transactionBegun) {
+
+    _d->db.commit();
+    _d->transactionBegun = false;
+    if (_d->journalLocked) {
+
+      _d->journalLocked = false;
+      unlockJournal (_d->db);
+    }
+  }
+  _committed = true;
 }
 
 // -----------------------------------------------------------------------------
-bool Pidbm::Private::idExists (const std::string & from, const long long & id) {
+void Pidbm::Private::checkDatabaseSchemaVersion() {
 
-  return idExists (from, to_string (id));
+  checkDatabaseSchemaVersion (db);
 }
 
 // -----------------------------------------------------------------------------
-void Pidbm::Private::checkDatabaseSchemaVersion() {
+void Pidbm::Private::checkDatabaseSchemaVersion (cppdb::session & db) {
   int major, minor;
   cppdb::result res =
     db << "SELECT major,minor "
@@ -2162,37 +5340,256 @@ void Pidbm::Private::checkDatabaseSchemaVersion() {
 }
 
 // -----------------------------------------------------------------------------
-bool
-Pidbm::Private::findConnectionInfo () {
+// profile is a comma separated list of profile names and pragma=value,
+// the later ones take precedence.
+void Pidbm::Private::setSqliteProfile (const std::string & profile,
+                                       std::map<std::string, std::string> & pragmas) {
+  std::istringstream is (profile);
+  string item;
 
-  if (cinfo.empty()) {
-    const char * env;
+  while (getline (is, item, ',')) {
+    size_t eq;
 
-    env = std::getenv ("PIDUINO_CONN_INFO");
-    if (env) {
+    item.erase (0, item.find_first_not_of (" \t"));
+    item.erase (item.find_last_not_of (" \t") + 1);
+    if (item.empty()) {
 
-      cinfo.assign (env);
+      continue;
+    }
+    eq = item.find ('=');
+    if (eq == string::npos) {
+      auto p = SqliteProfiles.find (toLower (item));
+
+      if (p == SqliteProfiles.end()) {
+
+        throw std::invalid_argument ("unknown SQLite profile " + item);
+      }
+      setSqliteProfile (p->second, pragmas);
     }
     else {
-      std::string fn;
+      string name = toLower (item.substr (0, eq));
+      string value = toUpper (item.substr (eq + 1));
+      auto p = SqlitePragmas.find (name);
+
+      if (p == SqlitePragmas.end()) {
+
+        throw std::invalid_argument ("SQLite pragma " + name + " is not allowed");
+      }
+      if (p->second.empty()) {
+        char * end;
+
+        strtoll (value.c_str(), &end, 10);
+        if (value.empty() || *end != 0) {
 
-      env = std::getenv ("HOME");
-      if (env == NULL) {
+          throw std::invalid_argument ("invalid value for " + name + ": " + value);
+        }
+      }
+      else if (std::find (p->second.begin(), p->second.end(), value) == p->second.end()) {
+
+        throw std::invalid_argument ("invalid value for " + name + ": " + value);
+      }
+      pragmas[name] = value;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+// The profile comes from the sqlite_profile and sqlite_<pragma> keys of
+// piduino.conf, then from the --sqlite-profile option.
+void Pidbm::Private::applySqliteProfile() {
+
+  if (db.engine() == "sqlite3") {
+    std::map<std::string, std::string> pragmas;
+    string fn = configFilePath();
+
+    if (fileExists (fn)) {
+      ConfigFile cfg (fn);
+
+      setSqliteProfile (cfg.value ("sqlite_profile"), pragmas);
+      for (auto & p : SqlitePragmas) {
+        string v = cfg.value ("sqlite_" + p.first);
 
-        env = getpwuid (getuid())->pw_dir;
+        if (!v.empty()) {
+
+          setSqliteProfile (p.first + "=" + v, pragmas);
+        }
       }
+    }
+    setSqliteProfile (sqliteProfile, pragmas);
+
+    if (opReadOnly) {
 
-      if (env) {
+      // changing the journal mode writes to the database
+      pragmas.erase ("journal_mode");
+    }
+    for (auto & p : pragmas) {
+      // some pragmas return their new value
+      cppdb::result res = db << "PRAGMA " + p.first + "=" + p.second;
+
+      while (res.next())
+        ;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Copies all the tables in an in-memory SQLite database that replaces db, so
+// that the library and the commands work on it with the same queries, without
+// any I/O nor round trip to the server. The ids are the rowids and the names
+// and the foreign keys are indexed, so each lookup is a seek.
+void Pidbm::Private::loadSnapshot() {
+  cppdb::session mem ("sqlite3:db=:memory:");
+  vector<Table> tables (Tables);
+
+  tables.push_back ({ "schema_version", {}, {} });
+  mem.begin();
+  for (auto & t : tables) {
+    // the integer columns of the source, the others are copied as text
+    auto integer = integerColumns (db, t.name);
+    cppdb::result res = db << "SELECT * FROM " + t.name;
+    std::ostringstream ddl, ins;
+    vector<Record> rows;
+    Record r;
+    int cols = res.cols();
+
+    ddl << "CREATE TABLE " << t.name << " (";
+    ins << "INSERT INTO " << t.name << " (";
+    for (int c = 0; c < cols; c++) {
+      string n = res.name (c);
+
+      ddl << (c ? "," : "") << '"' << n << '"' << (integer[n] ? " INTEGER" : " TEXT");
+      if (t.key.size() == 1 && t.key[0] == "id" && n == "id") {
+
+        ddl << " PRIMARY KEY";
+      }
+      ins << (c ? "," : "") << '"' << n << '"';
+    }
+    if (t.key.size() > 1 || (t.key.size() == 1 && t.key[0] != "id")) {
 
-        fn.assign (env);
-        fn += "/.config/piduino.conf";
+      ddl << ", PRIMARY KEY (";
+      for (size_t i = 0; i < t.key.size(); i++) {
+        ddl << (i ? "," : "") << '"' << t.key[i] << '"';
       }
+      ddl << ')';
+    }
+    ddl << ')';
+    ins << ") VALUES";
+    mem << ddl.str() << cppdb::exec;
 
-      if (!fileExists (fn)) {
+    while (res.next()) {
+
+      r.values.resize (cols);
+      r.null.resize (cols);
+      for (int c = 0; c < cols; c++) {
+        r.null[c] = !res.fetch (c, r.values[c]);
+      }
+      rows.push_back (r);
+    }
 
-        fn.assign (PIDUINO_INSTALL_ETC_DIR);
-        fn += "/piduino.conf";
+    const size_t chunk = std::max (1, static_cast<int> (MaxBindParameters) / std::max (1, cols));
+    for (size_t first = 0; first < rows.size(); first += chunk) {
+      size_t last = std::min (rows.size(), first + chunk);
+      std::ostringstream req;
+      cppdb::statement st;
+
+      req << ins.str();
+      for (size_t i = first; i < last; i++) {
+        req << (i > first ? ",(" : "(");
+        for (int c = 0; c < cols; c++) {
+          req << (c ? ",?" : "?");
+        }
+        req << ')';
+      }
+      st = mem << req.str();
+      for (size_t i = first; i < last; i++) {
+        for (int c = 0; c < cols; c++) {
+          if (rows[i].null[c]) {
+            st.bind_null();
+          }
+          else {
+            st << rows[i].values[c];
+          }
+        }
       }
+      st.exec();
+    }
+
+    if (std::find (t.columns.begin(), t.columns.end(), "name") != t.columns.end()) {
+
+      mem << "CREATE INDEX " + t.name + "_name ON " + t.name + "(name)" << cppdb::exec;
+      mem << "CREATE INDEX " + t.name + "_lname ON " + t.name + "(lower(name))" << cppdb::exec;
+    }
+  }
+
+  for (auto & fk : ForeignKeys) {
+
+    mem << "CREATE INDEX " + fk.table + "_" + fk.column + " ON " +
+        fk.table + "(\"" + fk.column + "\")" << cppdb::exec;
+  }
+  mem.commit();
+  mem << "PRAGMA query_only=ON" << cppdb::exec;
+  db = mem;
+}
+
+// -----------------------------------------------------------------------------
+// The backend refuses any write on the session, as a second barrier
+// after the rejection of the write commands by exec().
+void Pidbm::Private::setReadOnly() {
+
+  if (db.engine() == "sqlite3") {
+
+    db << "PRAGMA query_only=ON" << cppdb::exec;
+  }
+  else if (db.engine() == "postgresql") {
+
+    db << "SET SESSION CHARACTERISTICS AS TRANSACTION READ ONLY" << cppdb::exec;
+  }
+  else if (db.engine() == "mysql") {
+
+    db << "SET SESSION TRANSACTION READ ONLY" << cppdb::exec;
+  }
+}
+
+// -----------------------------------------------------------------------------
+std::string
+Pidbm::Private::configFilePath () const {
+  std::string fn;
+  const char * env;
+
+  env = std::getenv ("HOME");
+  if (env == NULL) {
+
+    env = getpwuid (getuid())->pw_dir;
+  }
+
+  if (env) {
+
+    fn.assign (env);
+    fn += "/.config/piduino.conf";
+  }
+
+  if (!fileExists (fn)) {
+
+    fn.assign (PIDUINO_INSTALL_ETC_DIR);
+    fn += "/piduino.conf";
+  }
+  return fn;
+}
+
+// -----------------------------------------------------------------------------
+bool
+Pidbm::Private::findConnectionInfo () {
+
+  if (cinfo.empty()) {
+    const char * env;
+
+    env = std::getenv ("PIDUINO_CONN_INFO");
+    if (env) {
+
+      cinfo.assign (env);
+    }
+    else {
+      std::string fn = configFilePath();
 
       if (fileExists (fn)) {
         ConfigFile cfg (fn);
@@ -18,13 +18,17 @@
 #include <cppdb/frontend.h>
 #include "pidbm.h"
 #include <iostream>
+#include <sstream>
+#include <algorithm>
 #include <vector>
+#include <cstdint>
 
 namespace pidbm {
   std::string progName();
   bool fileExists (const std::string & path);
   std::string toUpper (const std::string & s);
   std::string toLower (const std::string & s);
+  std::vector<std::string> splitWords (const std::string & line);
 }
 
 class Pidbm::Private {
@@ -34,7 +38,14 @@ class Pidbm::Private {
     Private (Pidbm * q, int argc, char **argv);
     virtual ~Private();
     bool findConnectionInfo ();
+    std::string configFilePath () const;
+    void applySqliteProfile();
+    void setReadOnly();
+    void loadSnapshot();
+    static void setSqliteProfile (const std::string & profile,
+                                  std::map<std::string, std::string> & pragmas);
     void checkDatabaseSchemaVersion();
+    static void checkDatabaseSchemaVersion (cppdb::session & s);
 
     void list();
     void add();
@@ -42,6 +53,19 @@ class Pidbm::Private {
     void remove();
     void show();
     void copy();
+    void generate();
+    void check();
+    void diff();
+    void sync();
+    void hash();
+    void log();
+    void find();
+    void index();
+    void where();
+    void gc();
+    void dedup();
+    void compat();
+    void mux();
 
     long long printRecordEqual (const std::vector<std::string> & what,
                                 const std::string & from,
@@ -56,28 +80,46 @@ class Pidbm::Private {
                            const std::vector<std::string> & condition = std::vector<std::string>(),
                            const std::string & orderby = std::string(),
                            const std::string & groupby = std::string());
-    long long selectRecordEqual (cppdb::result & res,
-                                 const std::vector<std::string> & what,
-                                 const std::string & from,
-                                 const std::string & where = std::string(),
-                                 const std::string & condition = std::string(),
-                                 bool like = false,
-                                 const std::string & orderby = std::string(),
-                                 const std::string & groupby = std::string());
-    template <class T>
-    long long selectRecord (cppdb::result & res,
+    void selectRecordEqual (cppdb::result & res,
                             const std::vector<std::string> & what,
                             const std::string & from,
                             const std::string & where = std::string(),
-                            const std::vector<T> & condition = std::vector<T>(),
+                            const std::string & condition = std::string(),
+                            bool like = false,
                             const std::string & orderby = std::string(),
-                            const std::string & groupby = std::string());
-    // if ifNotExists set, first 'what' must be the id field to returned
+                            const std::string & groupby = std::string(),
+                            long long limit = 0);
+    // limit > 0 adds a LIMIT clause, 1 for the existence and first row lookups
+    template <class T>
+    void selectRecord (cppdb::result & res,
+                       const std::vector<std::string> & what,
+                       const std::string & from,
+                       const std::string & where = std::string(),
+                       const std::vector<T> & condition = std::vector<T>(),
+                       const std::string & orderby = std::string(),
+                       const std::string & groupby = std::string(),
+                       long long limit = 0);
+    // if ifNotExists set, nothing is added when a record with these values
+    // exists, returns the id of the record added or found
     template <class T>
     long long insertRecord (const std::vector<std::string> & what,
                             const std::string & to,
                             const std::vector<T> & values,
                             bool ifNotExists = false);
+    // multi-row insert, returns the number of records added, if ids is not
+    // null and the table has an id key, the ids added are appended in order.
+    // If ifNotExists is set, the records that exist are not added, their ids
+    // are not appended.
+    template <class T>
+    long long insertRecords (const std::vector<std::string> & what,
+                             const std::string & to,
+                             const std::vector<std::vector<T>> & rows,
+                             std::vector<long long> * ids = nullptr,
+                             bool ifNotExists = false);
+    // beginning and end of an INSERT, an upsert ignores the records that
+    // conflict with the unique key on columns
+    std::string insertHead (bool upsert);
+    std::string insertTail (bool upsert, const std::string & columns);
     void updateRecord (const std::vector<std::string> & what,
                        const std::string & to,
                        const std::string & where,
@@ -97,14 +139,39 @@ class Pidbm::Private {
     bool readArg (const std::string & arg, const std::string & from, long long & id, bool caseInsensitive = false);
     bool readArg (const std::string & arg, const std::string & from, std::string & id, bool caseInsensitive = false);
     template <class T> bool searchPinId (const std::string & nameOrId, T & id);
+    size_t resolvePins (const std::vector<std::string> & selectors,
+                        std::vector<std::vector<long long>> & pins);
+    std::vector<std::string> readInputLines();
+    long long copyGpio (long long id, const std::string & name);
+    long long printPinModeMatrix (long long soc_id, const std::string & soc_name);
+    void journal (const std::string & table, char operation, const std::string & key);
+    void journal (const std::string & table, char operation, const std::vector<std::string> & keys);
+    template <class T> void journalKeys (const std::string & table, char operation,
+                                         const std::string & where,
+                                         const std::vector<T> & condition);
+    template <class T> static std::string rowKey (const std::string & table,
+        const std::vector<std::string> & what,
+        const std::vector<T> & values);
+    void openJournal();
+    void beginWrite();
+    static void createJournal (cppdb::session & s);
+    static void lockJournal (cppdb::session & s);
+    static void unlockJournal (cppdb::session & s);
+    static void journal (cppdb::session & s, const std::string & table, char operation,
+                         const std::vector<std::string> & keys);
     long long nameExists (const std::string & from, const std::string & name, bool caseInsensitive = false);
     bool idExists (const std::string & from, const std::string & id);
     bool idExists (const std::string & from, const long long & id);
-    static void printTable (cppdb::result & res, std::vector<int> & colen,
-                            const std::vector<std::string> & what);
+    bool indexExists (const std::string & name);
+    // true if an unique constraint on exactly these columns exists
+    bool hasUniqueKey (const std::string & table, const std::vector<std::string> & columns);
+    int sqliteVersion(); // 3024000 for 3.24.0
+    size_t bindParameterLimit(); // bound parameters per statement
     static void printTableHeader (cppdb::result & res, std::vector<int> & colen,
                                   const std::vector<std::string> & what);
     static void printTableLine (std::vector<int> & colen);
+    static void printTable (const std::vector<std::string> & header,
+                            const std::vector<std::vector<std::string>> & rows);
     static std::string columnNameCleanup (const std::string & name);
 
     Pidbm * const q_ptr;
@@ -114,19 +181,108 @@ class Pidbm::Private {
     bool opWarranty;
     bool opVersion;
     bool opQuiet;
+    bool opDryRun;
+    bool opReadOnly;
+    bool opInMemory;
+    bool opPivot;
     std::shared_ptr<Popl::Value<std::string>> opRevision;
     std::shared_ptr<Popl::Value<std::string>> opMemory;
     std::shared_ptr<Popl::Value<std::string>> opTag;
     std::shared_ptr<Popl::Value<std::string>> opPCB;
     std::shared_ptr<Popl::Implicit<std::string>> opPinMode;
+    std::shared_ptr<Popl::Value<std::string>> opFromFile;
+    std::shared_ptr<Popl::Value<std::string>> opOrder;
+    std::shared_ptr<Popl::Value<long long>> opSince;
+    std::shared_ptr<Popl::Value<std::string>> opConnectorFamily;
+    std::shared_ptr<Popl::Value<std::string>> opFunctions;
 
     std::string cinfo;
+    std::string sqliteProfile;
     mutable cppdb::session db;
+    int transactionDepth;
+    bool transactionBegun;
+    bool journalReady;
+    bool journalLocked;
+    int sqliteVersionNumber;
+    // run by exec() once the command has been committed, VACUUM for example
+    // can not be run in a transaction
+    std::vector<std::string> afterCommit;
+    std::map<std::string, bool> uniqueKeyCache;
+
+    // Transaction on db that can be nested, only the outermost one commits or
+    // rolls back (if commit() has not been called). The outermost one begins
+    // at the first write (beginWrite()), so that a read-only command or a
+    // confirmation prompt does not hold the lock, a nested one is a write
+    // section and begins at once.
+    class Transaction {
+      public:
+        Transaction (Private * d);
+        ~Transaction();
+        void commit();
+      private:
+        Private * _d;
+        bool _committed;
+    };
 
     static const std::string Authors;
     static const std::string Website;
     static const std::string Description;
     static const  std::map<std::string, std::vector<std::string>> WhatMap;
+    static const size_t MaxBindParameters; // lowest limit of the backends
+    static const std::vector<std::string> WriteCommands;
+    // pragma -> allowed values, an empty list for an integer
+    static const std::map<std::string, std::vector<std::string>> SqlitePragmas;
+    static const std::map<std::string, std::string> SqliteProfiles;
+
+    class ForeignKey {
+      public:
+        std::string table;
+        std::string column;
+        std::string parent; // referenced table, by its id
+    };
+    // ordered so that a parent table comes before its children
+    static const std::vector<ForeignKey> ForeignKeys;
+
+    class Rule {
+      public:
+        std::string description;
+        std::string query; // returns the rows that violate the rule
+    };
+    static const std::vector<Rule> CheckRules;
+
+    class Table {
+      public:
+        std::string name;
+        std::vector<std::string> key;
+        std::vector<std::string> columns; // without the key
+    };
+    // ordered so that a parent table comes before its children
+    static const std::vector<Table> Tables;
+    // unique keys of the insertRecord() existence checks, <table>_uniq
+    // indexes created by the index command, the columns are in key
+    static const std::vector<Table> UniqueKeys;
+
+    class Record {
+      public:
+        std::vector<std::string> values;
+        std::vector<bool> null;
+    };
+    class Change {
+      public:
+        const Table * table;
+        char op; // '-' delete, '+' insert, '~' update
+        Record record; // record to delete, to insert or new values
+        Record old;    // old values for an update
+    };
+    static size_t compareDatabases (cppdb::session & a, cppdb::session & b,
+                                    std::vector<Change> & changes);
+    static void applyChanges (cppdb::session & s, const std::vector<Change> & changes);
+    static void printChange (const Change & c, std::ostream & os = std::cout);
+    static uint64_t tableHash (cppdb::session & s, const Table & t);
+    static std::map<std::string, bool> integerColumns (cppdb::session & s,
+        const std::string & table);
+    static std::string keyOrder (cppdb::session & s, const Table & t);
+    static const Table * findTable (const std::string & name);
     PIMP_DECLARE_PUBLIC (Pidbm)
 };
 
@@ -140,7 +296,13 @@ long long Pidbm::Private::insertRecord (const std::vector<std::string> & what,
   cppdb::result res;
   std::ostringstream req;
   std::string where;
+  std::string columns;
   std::vector<std::string> what_cleaned;
+  const Table * t = findTable (to);
+  const bool hasId = t && t->key.size() == 1 && t->key[0] == "id";
+  const std::string engine = db.engine();
+  bool upsert;
+  bool added = false;
   long long id = -1;
 
   for (size_t i = 0; i < what.size(); i++) {
@@ -158,137 +320,355 @@ long long Pidbm::Private::insertRecord (const std::vector<std::string> & what,
         where += " AND ";
       }
     }
+    columns += (i > 0 ? "," : "") + w;
     what_cleaned.push_back (w);
   }
 
-  if (ifNotExists) {
+  // with an unique key on these columns, the backend checks the existence
+  // in the INSERT itself, that is atomic with the concurrent writers
+  upsert = ifNotExists && hasUniqueKey (to, what_cleaned);
+  if (ifNotExists && !upsert) {
 
-    selectRecord (res, what_cleaned, to, where, values);
+    selectRecord (res, { hasId ? "id" : what_cleaned[0] }, to, where, values, "", "", 1);
     if (res.next()) {
       res >> id;
     }
   }
 
   if (id < 0) {
-    req << "INSERT INTO " << to << "(";
-    for (size_t i = 0; i < what_cleaned.size(); i++) {
+    // a returned id avoids the lastval() query of PostgreSQL
+    const bool returning = hasId && engine == "postgresql";
 
-      req << what_cleaned[i];
-      if (i < (what_cleaned.size() - 1)) {
-        req << ',';
-      }
-    }
-    req << ") VALUES(";
+    req << insertHead (upsert) << to << "(" << columns << ") VALUES(";
     for (size_t i = 0; i < what_cleaned.size(); i++) {
       req << '?';
       if (i < (what_cleaned.size() - 1)) {
         req << ',';
       }
     }
-    req << ')';
+    req << ')' << insertTail (upsert, columns);
+    if (returning) {
+
+      req << " RETURNING id";
+    }
     //std::cout << req.str() << std::endl; // debug
 
+    beginWrite();
     st = db << req.str();
     for (auto v : values) {
       st << v;
     }
-    st.exec();
+    if (returning) {
 
-    id = st.last_insert_id();
-    if (!opQuiet) {
+      res = st.query();
+      if (res.next()) {
+        res >> id;
+        added = true;
+      }
+    }
+    else {
 
-      std::cout << "New " << to << " (id:" <<  id << ") added." << std::endl;
+      st.exec();
+      added = st.affected() > 0;
+      if (added) {
+        id = st.last_insert_id();
+      }
     }
-  }
-  else {
 
-    if (!opQuiet) {
+    if (added) {
+
+      if (hasId) {
+
+        journal (to, 'I', "id=" + std::to_string (id));
+      }
+      else {
+
+        journal (to, 'I', rowKey (to, what_cleaned, values));
+      }
+      if (!opQuiet) {
+
+        std::cout << "New " << to << " (id:" <<  id << ") added." << std::endl;
+      }
+      return id;
+    }
 
-      std::cout << "this record is already in the " << to << " table, nothing to add." <<  std::endl;
+    // upsert conflict, the record was already there
+    if (hasId) {
+
+      selectRecord (res, { "id" }, to, where, values, "", "", 1);
+      if (res.next()) {
+        res >> id;
+      }
     }
   }
+
+  if (!opQuiet) {
+
+    std::cout << "this record is already in the " << to << " table, nothing to add." <<  std::endl;
+  }
   return id;
 }
 
 
 // -----------------------------------------------------------------------------
 template <class T>
-long long Pidbm::Private::selectRecord (cppdb::result & res,
-                                        const std::vector<std::string> & what,
-                                        const std::string & from,
-                                        const std::string & where,
-                                        const std::vector<T> & condition,
-                                        const std::string & orderby,
-                                        const std::string & groupby) {
+long long Pidbm::Private::insertRecords (const std::vector<std::string> & what,
+    const std::string & to,
+    const std::vector<std::vector<T>> & rows,
+    std::vector<long long> * ids,
+    bool ifNotExists) {
   long long n = 0;
-  std::ostringstream req;
-  cppdb::statement st;
+  const Table * t = findTable (to);
+  const bool hasId = t && t->key.size() == 1 && t->key[0] == "id";
+  std::vector<long long> newIds;
+  const bool upsert = ifNotExists && hasUniqueKey (to, what);
+  // RETURNING needs SQLite 3.35, MySQL only gives the first id of a statement,
+  // the keys returned journal only the records added by an upsert
+  const bool returning = (hasId || (upsert && t)) &&
+                         (db.engine() == "postgresql" ||
+                          (db.engine() == "sqlite3" && sqliteVersion() >= 3035000));
+  // rows per statement, the number of parameters is limited by the backend
+  const size_t chunk = (hasId && !returning) ? 1 :
+                       std::max (static_cast<size_t> (1), bindParameterLimit() / what.size());
+  const std::vector<std::vector<T>> * todo = &rows;
+  std::vector<std::vector<T>> missing;
+  std::vector<std::string> keys;
+  std::string columns;
+
+  if (!ids) {
+    // the ids are needed by the journal
+    ids = &newIds;
+  }
+  for (size_t i = 0; i < what.size(); i++) {
+    columns += (i > 0 ? "," : "") + what[i];
+  }
 
-  // query to count the number of lines
-  req << "SELECT COUNT(*) FROM " << from;
+  if (ifNotExists && !upsert) {
+    // without unique key, the existence of each record is checked before
+    std::string where;
 
-  if (where.size() && condition.size()) {
+    for (size_t i = 0; i < what.size(); i++) {
+      where += (i > 0 ? " AND " : "") + what[i] + "=?";
+    }
+    for (auto & r : rows) {
+      cppdb::result res;
 
-    req << " WHERE " << where;
-    st = db << req.str();
-    for (auto c : condition) {
-      st << c;
+      selectRecord (res, { what[0] }, to, where, r, "", "", 1);
+      if (!res.next() && std::find (missing.begin(), missing.end(), r) == missing.end()) {
+        missing.push_back (r);
+      }
     }
+    todo = &missing;
   }
-  else {
-    st = db << req.str();
-  }
-  //std::cout << req.str() << std::endl; // debug
-  res = st.row();
-
-  if (!res.empty()) {
 
-    res >> n;
-    if (n > 0) {
+  for (size_t first = 0; first < todo->size(); first += chunk) {
+    size_t last = std::min (todo->size(), first + chunk);
+    std::ostringstream req;
+    cppdb::statement st;
 
-      // query to be performed the result
-      req.str ("");
-      req.clear();
+    req << insertHead (upsert) << to << "(" << columns << ") VALUES";
+    for (size_t r = first; r < last; r++) {
 
-      req << "SELECT ";
+      req << (r > first ? ",(" : "(");
       for (size_t i = 0; i < what.size(); i++) {
-        std::string str (what[i]);
-
-        if (str[0] == '%') {
-          str.erase (0, 1);
-          str = "printf(\"0x%x\"," + str + ")";
-        }
-        req << str;
+        req << '?';
         if (i < (what.size() - 1)) {
           req << ',';
         }
       }
-      req << " FROM " << from;
-      if (where.size() && condition.size()) {
-        req << " WHERE " << where;
+      req << ')';
+    }
+    req << insertTail (upsert, columns);
+    if (returning) {
+
+      req << " RETURNING ";
+      for (size_t k = 0; k < t->key.size(); k++) {
+        req << (k ? "," : "") << t->key[k];
+      }
+    }
+    //std::cout << req.str() << std::endl; // debug
+
+    beginWrite();
+    st = db << req.str();
+    for (size_t r = first; r < last; r++) {
+      for (auto v : (*todo) [r]) {
+        st << v;
       }
-      if (groupby.size()) {
-        req << " GROUP BY " << groupby;
+    }
+    if (returning) {
+      cppdb::result res = st.query();
+      size_t begin = hasId ? ids->size() : 0;
+
+      while (res.next()) {
+        std::ostringstream key;
+
+        for (int c = 0; c < res.cols(); c++) {
+          std::string value;
+
+          res.fetch (c, value);
+          key << (c ? "," : "") << t->key[c] << '=' << value;
+        }
+        if (hasId) {
+          long long id;
+
+          res.fetch (0, id);
+          ids->push_back (id);
+        }
+        keys.push_back (key.str());
+        n++;
       }
-      if (orderby.size()) {
-        req << " ORDER BY " << orderby;
+      if (hasId) {
+        // the ids are allocated in the order of the rows, not necessarily returned
+        std::sort (ids->begin() + begin, ids->end());
       }
+    }
+    else {
+      long long added;
 
-      //std::cout << req.str() << std::endl; // debug
+      st.exec();
+      added = st.affected();
+      n += added;
+      if (hasId && added > 0) {
 
-      st = db << req.str();
-      if (where.size() && condition.size()) {
+        ids->push_back (st.last_insert_id());
+        keys.push_back ("id=" + std::to_string (ids->back()));
+      }
+      else if (!hasId && added == static_cast<long long> (last - first)) {
 
-        for (auto c : condition) {
-          st << c;
+        for (size_t r = first; r < last; r++) {
+          keys.push_back (rowKey (to, what, (*todo) [r]));
         }
       }
-      res = st.query();
+      else if (!hasId && added > 0) {
+
+        // an upsert that ignored some records, which ones is not known
+        keys.push_back (std::string());
+      }
     }
   }
+
+  journal (to, 'I', keys);
   return n;
 }
 
+// -----------------------------------------------------------------------------
+// "column=value,..." key of a record of table from the values of its columns
+// what, an empty string if a key column is missing (id for an insertion)
+template <class T>
+std::string Pidbm::Private::rowKey (const std::string & table,
+                                    const std::vector<std::string> & what,
+                                    const std::vector<T> & values) {
+  const Table * t = findTable (table);
+  std::ostringstream key;
+
+  if (t) {
+
+    for (size_t k = 0; k < t->key.size(); k++) {
+      auto i = std::find (what.begin(), what.end(), t->key[k]);
+
+      if (i == what.end()) {
+
+        return std::string();
+      }
+      key << (k ? "," : "") << t->key[k] << '=' << values.at (i - what.begin());
+    }
+  }
+  return key.str();
+}
+
+// -----------------------------------------------------------------------------
+// Journals the keys of the records of table matching where, must be called
+// before a deletion or an update, after an insertion.
+template <class T>
+void Pidbm::Private::journalKeys (const std::string & table, char operation,
+                                  const std::string & where,
+                                  const std::vector<T> & condition) {
+  const Table * t = findTable (table);
+
+  beginWrite();
+  if (t) {
+    std::ostringstream req;
+    std::vector<std::string> keys;
+    cppdb::statement st;
+    cppdb::result res;
+
+    req << "SELECT ";
+    for (size_t i = 0; i < t->key.size(); i++) {
+      req << (i ? "," : "") << t->key[i];
+    }
+    req << " FROM " << table << " WHERE " << where;
+
+    st = db << req.str();
+    for (auto & c : condition) {
+      st << c;
+    }
+    res = st.query();
+    while (res.next()) {
+      std::ostringstream key;
+
+      for (int c = 0; c < res.cols(); c++) {
+        std::string value;
+
+        res.fetch (c, value);
+        key << (c ? "," : "") << t->key[c] << '=' << value;
+      }
+      keys.push_back (key.str());
+    }
+    journal (table, operation, keys);
+  }
+}
+
+// -----------------------------------------------------------------------------
+template <class T>
+void Pidbm::Private::selectRecord (cppdb::result & res,
+                                   const std::vector<std::string> & what,
+                                   const std::string & from,
+                                   const std::string & where,
+                                   const std::vector<T> & condition,
+                                   const std::string & orderby,
+                                   const std::string & groupby,
+                                   long long limit) {
+  std::ostringstream req;
+  cppdb::statement st;
+
+  req << "SELECT ";
+  for (size_t i = 0; i < what.size(); i++) {
+    std::string str (what[i]);
+
+    if (str[0] == '%') {
+      str.erase (0, 1);
+      str = "printf(\"0x%x\"," + str + ")";
+    }
+    req << str;
+    if (i < (what.size() - 1)) {
+      req << ',';
+    }
+  }
+  req << " FROM " << from;
+  if (where.size() && condition.size()) {
+    req << " WHERE " << where;
+  }
+  if (groupby.size()) {
+    req << " GROUP BY " << groupby;
+  }
+  if (orderby.size()) {
+    req << " ORDER BY " << orderby;
+  }
+  if (limit > 0) {
+    req << " LIMIT " << limit;
+  }
+  //std::cout << req.str() << std::endl; // debug
+
+  st = db << req.str();
+  if (where.size() && condition.size()) {
+
+    for (auto c : condition) {
+      st << c;
+    }
+  }
+  res = st.query();
+}
+
 // -----------------------------------------------------------------------------
 template <class T>
 bool Pidbm::Private::searchPinId (const std::string & nameOrId, T & id) {
@@ -312,11 +692,12 @@ bool Pidbm::Private::searchPinId (const std::string & nameOrId, T & id) {
     condition = pidbm::toLower (condition);
     cv.push_back (condition);
     cv.push_back ("0"); // input
-    if (selectRecord (res, {"pin_id"}, from, where, cv) == 1) {
-      if (res.next()) {
-        res >> id;
-        return true;
-      }
+    // two rows at most, to know if the name is ambiguous
+    selectRecord (res, {"pin_id"}, from, where, cv, "", "", 2);
+    if (res.next()) {
+
+      res >> id;
+      return !res.next();
     }
   }
   return false;